@@ -0,0 +1,110 @@
+#include "albumartcache.h"
+#include "coverstore.h"
+#include "trace.h"
+
+namespace {
+    constexpr int PIXMAP_CACHE_KB = 64 * 1024;
+    constexpr int SOURCE_CACHE_KB = 48 * 1024;
+
+    int costOf(const QImage &image)
+    {
+        return qMax(1, int(image.sizeInBytes() / 1024));
+    }
+
+    QString variantKey(const QString &key, int size)
+    {
+        return key + '@' + QString::number(size);
+    }
+}
+
+AlbumArtCache::AlbumArtCache()
+    : m_pixmaps(PIXMAP_CACHE_KB)
+    , m_sources(SOURCE_CACHE_KB)
+{
+}
+
+bool AlbumArtCache::hasArt(const TrackInfo &track) const
+{
+    const QString key = track.artKey();
+    return !key.isEmpty() && !m_broken.contains(key);
+}
+
+QPixmap AlbumArtCache::pixmap(const TrackInfo &track, int size)
+{
+    if (!hasArt(track) || size <= 0) {
+        return QPixmap();
+    }
+    const QPixmap *cached = m_pixmaps.object(variantKey(track.artKey(), size));
+    return cached ? *cached : QPixmap();
+}
+
+QImage AlbumArtCache::source(const TrackInfo &track)
+{
+    if (!hasArt(track)) {
+        return QImage();
+    }
+    const QImage *cached = m_sources.object(track.artKey());
+    return cached ? *cached : QImage();
+}
+
+QPixmap AlbumArtCache::preview(const TrackInfo &track, int size)
+{
+    const QImage image = source(track);
+    if (image.isNull() || size <= 0) {
+        return QPixmap();
+    }
+    return QPixmap::fromImage(image.scaled(size, size, Qt::KeepAspectRatio, Qt::FastTransformation));
+}
+
+void AlbumArtCache::insert(const QString &key, const QImage &source, const QHash<int, QImage> &scaled)
+{
+    if (key.isEmpty()) {
+        return;
+    }
+    if (source.isNull()) {
+        m_broken.insert(key);
+        return;
+    }
+
+    m_sources.insert(key, new QImage(source), costOf(source));
+    for (auto it = scaled.cbegin(); it != scaled.cend(); ++it) {
+        m_pixmaps.insert(variantKey(key, it.key()), new QPixmap(QPixmap::fromImage(it.value())), costOf(it.value()));
+    }
+}
+
+QImage AlbumArtCache::decode(const TrackInfo &track)
+{
+    TRACE_SCOPE("decode art");
+    const QString key = track.artKey();
+    if (key.isEmpty()) {
+        return QImage();
+    }
+
+    QImage image = CoverStore::master(key);
+    if (image.isNull()) {
+        // Not stored yet or the cache was cleared; recover it from the track
+        QByteArray picture;
+        TrackInfo::read(track.filePath, &picture);
+        if (!image.loadFromData(picture)) {
+            return QImage();
+        }
+        CoverStore::store(key, picture);
+        if (image.width() > CoverStore::MASTER_SIZE || image.height() > CoverStore::MASTER_SIZE) {
+            image = image.scaled(CoverStore::MASTER_SIZE, CoverStore::MASTER_SIZE,
+                                 Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+    }
+    return image;
+}
+
+QImage AlbumArtCache::scale(const QString &key, const QImage &source, int size)
+{
+    TRACE_SCOPE("scale art");
+    if (CoverStore::isThumbnailSize(size)) {
+        const QImage thumbnail = CoverStore::thumbnail(key, size);
+        if (!thumbnail.isNull()) {
+            return thumbnail;
+        }
+    }
+    return source.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
@@ -0,0 +1,50 @@
+#ifndef ALBUMARTCACHE_H
+#define ALBUMARTCACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QSet>
+#include <QString>
+#include "trackinfo.h"
+
+// Album art at the sizes the UI draws, keyed by the content hash of the
+// embedded picture so tracks sharing a cover share one entry. Scaled
+// pixmaps and decoded covers live in in-memory LRUs; lookups never touch
+// the disk. What is missing is decoded by an ArtLoader, from the on-disk
+// CoverStore, and added here when it is ready.
+class AlbumArtCache
+{
+public:
+    AlbumArtCache();
+
+    // False once the track's art has turned out not to decode
+    bool hasArt(const TrackInfo &track) const;
+
+    // Art for track scaled to fit size x size, null if not in memory
+    QPixmap pixmap(const TrackInfo &track, int size);
+    // The decoded cover, null if not in memory
+    QImage source(const TrackInfo &track);
+    // A rough, uncached scale of the decoded cover for sizes that are only
+    // shown for a moment, such as during a window resize; null if the
+    // cover is not in memory
+    QPixmap preview(const TrackInfo &track, int size);
+
+    // What an ArtLoader made; a null source marks the art as broken
+    void insert(const QString &key, const QImage &source, const QHash<int, QImage> &scaled);
+
+    // Decodes the track's cover, from the cover store or failing that the
+    // file. Slow; safe on any thread
+    static QImage decode(const TrackInfo &track);
+    // Scales a decoded cover to fit size x size, from the stored thumbnail
+    // if there is one. Safe on any thread
+    static QImage scale(const QString &key, const QImage &source, int size);
+
+private:
+    QCache<QString, QPixmap> m_pixmaps;
+    QCache<QString, QImage> m_sources;
+    QSet<QString> m_broken;
+};
+
+#endif // ALBUMARTCACHE_H
@@ -0,0 +1,249 @@
+#include "albumgridview.h"
+#include "albumlistmodel.h"
+#include "thumbnailloader.h"
+#include <QEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QStyledItemDelegate>
+
+namespace {
+    constexpr int COVER_SIZE = 150;
+    constexpr int PADDING = 8;
+
+    // Paints a grid cell from the loader's ready-made cover, or a plain
+    // placeholder until it arrives; never scales or decodes
+    class AlbumGridDelegate : public QStyledItemDelegate
+    {
+    public:
+        AlbumGridDelegate(ThumbnailLoader *loader, QObject *parent)
+            : QStyledItemDelegate(parent)
+            , m_loader(loader)
+        {
+        }
+
+        QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override
+        {
+            Q_UNUSED(index);
+            return QSize(COVER_SIZE + 2 * PADDING,
+                         COVER_SIZE + 2 * PADDING + 2 * option.fontMetrics.lineSpacing());
+        }
+
+        void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override
+        {
+            const QRect cell = option.rect.adjusted(PADDING / 2, PADDING / 2, -PADDING / 2, -PADDING / 2);
+            const bool selected = option.state & QStyle::State_Selected;
+            if (selected || (option.state & QStyle::State_MouseOver)) {
+                painter->save();
+                painter->setRenderHint(QPainter::Antialiasing);
+                painter->setPen(Qt::NoPen);
+                painter->setBrush(option.palette.color(QPalette::Highlight));
+                painter->setOpacity(selected ? 1.0 : 0.4);
+                painter->drawRoundedRect(cell, PADDING / 2, PADDING / 2);
+                painter->restore();
+            }
+
+            const QRect cover(option.rect.x() + (option.rect.width() - COVER_SIZE) / 2,
+                              option.rect.y() + PADDING, COVER_SIZE, COVER_SIZE);
+            QPixmap pixmap = m_loader->pixmap(index.data(AlbumListModel::ArtKeyRole).toString());
+            if (pixmap.isNull()) {
+                pixmap = placeholder(option.palette.color(QPalette::Mid), painter->device()->devicePixelRatioF());
+            }
+            painter->drawPixmap(cover.topLeft(), pixmap);
+
+            const int lineHeight = option.fontMetrics.lineSpacing();
+            const QRect title(cell.x() + PADDING / 2, cover.bottom() + 1 + PADDING / 2,
+                              cell.width() - PADDING, lineHeight);
+            const QRect artist = title.translated(0, lineHeight);
+            painter->save();
+            painter->setFont(option.font);
+            painter->setPen(option.palette.color(selected ? QPalette::HighlightedText : QPalette::Text));
+            painter->drawText(title, Qt::AlignHCenter | Qt::AlignVCenter,
+                              option.fontMetrics.elidedText(index.data(AlbumListModel::TitleRole).toString(),
+                                                            Qt::ElideRight, title.width()));
+            painter->setOpacity(0.7);
+            painter->drawText(artist, Qt::AlignHCenter | Qt::AlignVCenter,
+                              option.fontMetrics.elidedText(index.data(AlbumListModel::ArtistRole).toString(),
+                                                            Qt::ElideRight, artist.width()));
+            painter->restore();
+        }
+
+    private:
+        // Made once per color and density, like the covers themselves
+        const QPixmap &placeholder(const QColor &color, qreal ratio) const
+        {
+            if (m_placeholder.isNull() || m_placeholderColor != color
+                    || !qFuzzyCompare(m_placeholder.devicePixelRatio(), ratio)) {
+                const int pixels = qRound(COVER_SIZE * ratio);
+                QPixmap pixmap(pixels, pixels);
+                pixmap.fill(Qt::transparent);
+                QPainter painter(&pixmap);
+                painter.setRenderHint(QPainter::Antialiasing);
+                painter.setPen(Qt::NoPen);
+                painter.setBrush(color);
+                painter.drawRoundedRect(QRectF(0, 0, pixels, pixels), pixels / 24.0, pixels / 24.0);
+                painter.end();
+                pixmap.setDevicePixelRatio(ratio);
+                m_placeholder = pixmap;
+                m_placeholderColor = color;
+            }
+            return m_placeholder;
+        }
+
+        ThumbnailLoader *m_loader;
+        mutable QPixmap m_placeholder;
+        mutable QColor m_placeholderColor;
+    };
+}
+
+AlbumGridView::AlbumGridView(QWidget *parent)
+    : QListView(parent)
+    , m_loader(new ThumbnailLoader(COVER_SIZE, this))
+    , m_grid(false)
+{
+    setUniformItemSizes(true);
+    m_listDelegate = itemDelegate();
+    m_gridDelegate = new AlbumGridDelegate(m_loader, this);
+
+    m_thumbnailTimer.setSingleShot(true);
+    m_thumbnailTimer.setInterval(0);
+    connect(&m_thumbnailTimer, &QTimer::timeout, this, &AlbumGridView::requestThumbnails);
+    connect(m_loader, &ThumbnailLoader::loaded, viewport(), [this]() {
+        viewport()->update();
+    });
+}
+
+void AlbumGridView::setGridMode(bool grid)
+{
+    m_grid = grid;
+    if (grid) {
+        setFlow(QListView::LeftToRight);
+        setWrapping(true);
+        setResizeMode(QListView::Adjust);
+        setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+        setGridSize(cellSize());
+        setItemDelegate(m_gridDelegate);
+        setMouseTracking(true);
+        scheduleThumbnails();
+    } else {
+        setFlow(QListView::TopToBottom);
+        setWrapping(false);
+        setResizeMode(QListView::Fixed);
+        setVerticalScrollMode(QAbstractItemView::ScrollPerItem);
+        setGridSize(QSize());
+        setItemDelegate(m_listDelegate);
+        setMouseTracking(false);
+    }
+    if (currentIndex().isValid()) {
+        scrollTo(currentIndex());
+    }
+}
+
+void AlbumGridView::setModel(QAbstractItemModel *model)
+{
+    QListView::setModel(model);
+    if (model) {
+        connect(model, &QAbstractItemModel::modelReset, this, &AlbumGridView::scheduleThumbnails,
+                Qt::UniqueConnection);
+        connect(model, &QAbstractItemModel::rowsRemoved, this, &AlbumGridView::scheduleThumbnails,
+                Qt::UniqueConnection);
+        // An album's cover changes as its tracks come and go
+        connect(model, &QAbstractItemModel::dataChanged, this, &AlbumGridView::scheduleThumbnails,
+                Qt::UniqueConnection);
+    }
+}
+
+void AlbumGridView::scrollContentsBy(int dx, int dy)
+{
+    QListView::scrollContentsBy(dx, dy);
+    scheduleThumbnails();
+}
+
+void AlbumGridView::resizeEvent(QResizeEvent *event)
+{
+    QListView::resizeEvent(event);
+    scheduleThumbnails();
+}
+
+void AlbumGridView::changeEvent(QEvent *event)
+{
+    QListView::changeEvent(event);
+    // The cells fit two lines of the view's font
+    if (m_grid && (event->type() == QEvent::FontChange || event->type() == QEvent::StyleChange)) {
+        setGridSize(cellSize());
+    }
+}
+
+void AlbumGridView::rowsInserted(const QModelIndex &parent, int start, int end)
+{
+    QListView::rowsInserted(parent, start, end);
+    scheduleThumbnails();
+}
+
+QSize AlbumGridView::cellSize() const
+{
+    return QSize(COVER_SIZE + 2 * PADDING, COVER_SIZE + 2 * PADDING + 2 * fontMetrics().lineSpacing());
+}
+
+void AlbumGridView::scheduleThumbnails()
+{
+    if (m_grid) {
+        m_thumbnailTimer.start();
+    }
+}
+
+void AlbumGridView::requestThumbnails()
+{
+    QAbstractItemModel *albums = model();
+    const int count = albums ? albums->rowCount(rootIndex()) : 0;
+    if (!m_grid || count == 0) {
+        return;
+    }
+    m_loader->setDevicePixelRatio(devicePixelRatioF());
+
+    const QRect visible = viewport()->rect();
+    const QRect nearby = visible.adjusted(0, -visible.height(), 0, visible.height());
+    const auto rectOf = [&](int row) {
+        return visualRect(albums->index(row, 0, rootIndex()));
+    };
+
+    // Start from the cell in the middle, or a guess from the scroll bar
+    // if that falls between cells, then step to the nearby band
+    int start = indexAt(visible.center()).row();
+    if (start < 0) {
+        const QScrollBar *bar = verticalScrollBar();
+        const int range = bar->maximum() + bar->pageStep();
+        start = range > 0 ? int(qint64(count) * bar->value() / range) : 0;
+    }
+    start = qBound(0, start, count - 1);
+    while (start > 0 && rectOf(start).top() > nearby.bottom()) {
+        --start;
+    }
+    while (start < count - 1 && rectOf(start).bottom() < nearby.top()) {
+        ++start;
+    }
+
+    QList<ThumbnailLoader::Cover> onScreen;
+    QList<ThumbnailLoader::Cover> offScreen;
+    const auto add = [&](int row, const QRect &rect) {
+        const QModelIndex index = albums->index(row, 0, rootIndex());
+        (rect.intersects(visible) ? onScreen : offScreen).append({
+            index.data(AlbumListModel::ArtKeyRole).toString(),
+            index.data(AlbumListModel::ArtPathRole).toString()
+        });
+    };
+    for (int row = start; row >= 0; --row) {
+        const QRect rect = rectOf(row);
+        if (rect.bottom() < nearby.top()) {
+            break;
+        }
+        add(row, rect);
+    }
+    for (int row = start + 1; row < count; ++row) {
+        const QRect rect = rectOf(row);
+        if (rect.top() > nearby.bottom()) {
+            break;
+        }
+        add(row, rect);
+    }
+    m_loader->prioritize(onScreen, offScreen);
+}
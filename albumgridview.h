@@ -0,0 +1,45 @@
+#ifndef ALBUMGRIDVIEW_H
+#define ALBUMGRIDVIEW_H
+
+#include <QListView>
+#include <QTimer>
+
+class ThumbnailLoader;
+
+// The albums page's view: a plain list of names, or a grid of covers with
+// title and artist below. Covers come from a ThumbnailLoader. After any
+// scroll, resize or model change the view tells it which cells are on
+// screen and which are within a screen above or below, walking out from
+// the middle of the viewport, so the work is bounded by what fits on
+// screen however many albums there are.
+class AlbumGridView : public QListView
+{
+    Q_OBJECT
+
+public:
+    explicit AlbumGridView(QWidget *parent = nullptr);
+
+    bool isGridMode() const { return m_grid; }
+    void setGridMode(bool grid);
+
+    void setModel(QAbstractItemModel *model) override;
+
+protected:
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void rowsInserted(const QModelIndex &parent, int start, int end) override;
+
+private:
+    QSize cellSize() const;
+    void scheduleThumbnails();
+    void requestThumbnails();
+
+    ThumbnailLoader *m_loader;
+    QAbstractItemDelegate *m_listDelegate;
+    QAbstractItemDelegate *m_gridDelegate;
+    QTimer m_thumbnailTimer;    // coalesces requests until layout is done
+    bool m_grid;
+};
+
+#endif // ALBUMGRIDVIEW_H
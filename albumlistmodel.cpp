@@ -0,0 +1,133 @@
+#include "albumlistmodel.h"
+
+AlbumListModel::AlbumListModel(TrackStore *store, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_store(store)
+    , m_filtered(false)
+    , m_artist(-1)
+{
+    // Row changes map one to one onto the full list. An artist's albums are
+    // few, so that view simply resets.
+    connect(m_store, &TrackStore::albumsAboutToBeInserted, this, [this](int first, int last) {
+        if (!m_filtered) {
+            beginInsertRows(QModelIndex(), first, last);
+        }
+    });
+    connect(m_store, &TrackStore::albumsInserted, this, [this]() {
+        if (!m_filtered) {
+            endInsertRows();
+        } else {
+            setArtist(m_artist);
+        }
+    });
+    connect(m_store, &TrackStore::albumsAboutToBeRemoved, this, [this](int first, int last) {
+        if (!m_filtered) {
+            beginRemoveRows(QModelIndex(), first, last);
+        }
+    });
+    connect(m_store, &TrackStore::albumsRemoved, this, [this]() {
+        if (!m_filtered) {
+            endRemoveRows();
+        } else {
+            setArtist(m_artist);
+        }
+    });
+    // Track counts and covers follow the tracks that join or leave
+    connect(m_store, &TrackStore::albumsChanged, this, [this](const QVector<int> &albumIds) {
+        for (int albumId : albumIds) {
+            const int row = !m_filtered ? m_store->albumRow(albumId) : int(m_albums.indexOf(albumId));
+            if (row >= 0) {
+                emit dataChanged(index(row), index(row), { TrackCountRole, ArtKeyRole, ArtPathRole });
+            }
+        }
+    });
+    connect(m_store, &TrackStore::artistsAboutToBeRemoved, this, [this](int first, int last) {
+        for (int row = first; row <= last; ++row) {
+            if (m_filtered && m_store->artistAt(row) == m_artist) {
+                setArtist(-1);
+            }
+        }
+    });
+}
+
+// -1 shows no albums, for when no artist is selected
+void AlbumListModel::setArtist(int artistId)
+{
+    beginResetModel();
+    m_filtered = true;
+    m_artist = artistId;
+    m_albums = artistId >= 0 ? m_store->artistAlbums(artistId) : QVector<int>();
+    endResetModel();
+}
+
+int AlbumListModel::albumId(int row) const
+{
+    return !m_filtered ? m_store->albumAt(row) : m_albums.at(row);
+}
+
+const QVector<int> &AlbumListModel::tracks(int row) const
+{
+    return m_store->albumTracks(albumId(row));
+}
+
+int AlbumListModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return !m_filtered ? m_store->albumCount() : m_albums.size();
+}
+
+QVariant AlbumListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount()) {
+        return QVariant();
+    }
+
+    const int id = albumId(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        // Same-named albums by different artists are separate rows
+        return !m_filtered
+            ? m_store->albumTitle(id) + QStringLiteral(" - ") + m_store->albumArtistName(id)
+            : m_store->albumTitle(id);
+    case TrackCountRole:
+        return m_store->albumTracks(id).size();
+    case TitleRole:
+        return m_store->albumTitle(id);
+    case ArtistRole:
+        return m_store->albumArtistName(id);
+    case ArtKeyRole: {
+        const int track = artTrack(id);
+        return track >= 0 ? m_store->artKey(track) : QString();
+    }
+    case ArtPathRole: {
+        const int track = artTrack(id);
+        return track >= 0 ? m_store->filePath(track) : QString();
+    }
+    default:
+        return QVariant();
+    }
+}
+
+int AlbumListModel::artTrack(int albumId) const
+{
+    for (int track : m_store->albumTracks(albumId)) {
+        if (!m_store->artKey(track).isEmpty()) {
+            return track;
+        }
+    }
+    return -1;
+}
+
+QHash<int, QByteArray> AlbumListModel::roleNames() const
+{
+    return {
+        { Qt::DisplayRole, "name" },
+        { TrackCountRole, "trackCount" },
+        { TitleRole, "title" },
+        { ArtistRole, "artist" },
+        { ArtKeyRole, "artKey" },
+        { ArtPathRole, "artPath" }
+    };
+}
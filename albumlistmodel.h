@@ -0,0 +1,41 @@
+#ifndef ALBUMLISTMODEL_H
+#define ALBUMLISTMODEL_H
+
+#include <QAbstractListModel>
+#include "trackstore.h"
+
+// One row per album in the store, in the store's sorted order, or only
+// the albums of one artist once setArtist() is called
+class AlbumListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        TrackCountRole = Qt::UserRole + 1,
+        TitleRole,
+        ArtistRole,
+        ArtKeyRole,         // cover of the album's first track with one
+        ArtPathRole         // file of that track
+    };
+
+    explicit AlbumListModel(TrackStore *store, QObject *parent = nullptr);
+
+    void setArtist(int artistId);
+    int albumId(int row) const;
+    const QVector<int> &tracks(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+private:
+    int artTrack(int albumId) const;
+
+    TrackStore *m_store;
+    bool m_filtered;
+    int m_artist;           // -1 for none
+    QVector<int> m_albums;  // album ids of m_artist
+};
+
+#endif // ALBUMLISTMODEL_H
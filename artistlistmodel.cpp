@@ -0,0 +1,62 @@
+#include "artistlistmodel.h"
+
+ArtistListModel::ArtistListModel(TrackStore *store, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_store(store)
+{
+    connect(m_store, &TrackStore::artistsAboutToBeInserted, this, [this](int first, int last) {
+        beginInsertRows(QModelIndex(), first, last);
+    });
+    connect(m_store, &TrackStore::artistsInserted, this, [this]() {
+        endInsertRows();
+    });
+    connect(m_store, &TrackStore::artistsAboutToBeRemoved, this, [this](int first, int last) {
+        beginRemoveRows(QModelIndex(), first, last);
+    });
+    connect(m_store, &TrackStore::artistsRemoved, this, [this]() {
+        endRemoveRows();
+    });
+    connect(m_store, &TrackStore::artistsChanged, this, [this](const QVector<int> &artistIds) {
+        for (int artistId : artistIds) {
+            const int row = m_store->artistRow(artistId);
+            if (row >= 0) {
+                emit dataChanged(index(row), index(row), { AlbumCountRole });
+            }
+        }
+    });
+}
+
+int ArtistListModel::artistId(int row) const
+{
+    return m_store->artistAt(row);
+}
+
+int ArtistListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_store->artistCount();
+}
+
+QVariant ArtistListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_store->artistCount()) {
+        return QVariant();
+    }
+
+    const int id = m_store->artistAt(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return m_store->artistName(id);
+    case AlbumCountRole:
+        return m_store->artistAlbums(id).size();
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> ArtistListModel::roleNames() const
+{
+    return {
+        { Qt::DisplayRole, "name" },
+        { AlbumCountRole, "albumCount" }
+    };
+}
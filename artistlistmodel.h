@@ -0,0 +1,29 @@
+#ifndef ARTISTLISTMODEL_H
+#define ARTISTLISTMODEL_H
+
+#include <QAbstractListModel>
+#include "trackstore.h"
+
+// One row per artist in the store, in the store's sorted order
+class ArtistListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        AlbumCountRole = Qt::UserRole + 1
+    };
+
+    explicit ArtistListModel(TrackStore *store, QObject *parent = nullptr);
+
+    int artistId(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+private:
+    TrackStore *m_store;
+};
+
+#endif // ARTISTLISTMODEL_H
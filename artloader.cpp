@@ -0,0 +1,52 @@
+#include "artloader.h"
+#include "albumartcache.h"
+
+ArtLoader::ArtLoader(QObject *parent)
+    : QObject(parent)
+    , m_generation(0)
+{
+    // One at a time; the GUI is waiting on it
+    m_pool.setMaxThreadCount(1);
+}
+
+ArtLoader::~ArtLoader()
+{
+    ++m_generation;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void ArtLoader::request(const TrackInfo &track, const QList<int> &sizes, const QImage &source)
+{
+    const quint64 generation = ++m_generation;
+    m_pool.clear();
+    m_pool.start([this, generation, track, sizes, source]() {
+        work(generation, track, sizes, source);
+    });
+}
+
+void ArtLoader::work(quint64 generation, const TrackInfo &track, const QList<int> &sizes, QImage source)
+{
+    if (generation != m_generation) {
+        return;
+    }
+
+    const QString key = track.artKey();
+    if (source.isNull()) {
+        source = AlbumArtCache::decode(track);
+    }
+
+    QHash<int, QImage> scaled;
+    if (!source.isNull()) {
+        for (int size : sizes) {
+            if (generation != m_generation) {
+                return;
+            }
+            scaled.insert(size, AlbumArtCache::scale(key, source, size));
+        }
+    }
+
+    if (generation == m_generation) {
+        emit ready(key, source, scaled);
+    }
+}
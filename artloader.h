@@ -0,0 +1,39 @@
+#ifndef ARTLOADER_H
+#define ARTLOADER_H
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QThreadPool>
+#include <atomic>
+#include "trackinfo.h"
+
+// Decodes and scales the playing track's cover on a background thread,
+// so a huge embedded picture never holds up the GUI. Only the latest
+// request matters: a new one drops any still waiting and makes one
+// already running give up at its next step.
+class ArtLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ArtLoader(QObject *parent = nullptr);
+    ~ArtLoader();
+
+    // Scales track's cover to each of sizes; source, if not null, is the
+    // decoded cover already at hand
+    void request(const TrackInfo &track, const QList<int> &sizes, const QImage &source = QImage());
+
+signals:
+    // source is null if the track's art could not be decoded
+    void ready(const QString &artKey, const QImage &source, const QHash<int, QImage> &scaled);
+
+private:
+    void work(quint64 generation, const TrackInfo &track, const QList<int> &sizes, QImage source);
+
+    QThreadPool m_pool;
+    std::atomic<quint64> m_generation;
+};
+
+#endif // ARTLOADER_H
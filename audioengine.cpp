@@ -0,0 +1,373 @@
+#include "audioengine.h"
+#include "decodeworker.h"
+#include "logging.h"
+#include <QMediaDevices>
+
+namespace {
+    // About 0.7 s at 48 kHz: plenty to ride out a slow decode, and seeks
+    // and skips discard it anyway
+    constexpr qsizetype RING_FRAMES = 1 << 15;
+    constexpr int CLOCK_INTERVAL = 50;  // msecs
+}
+
+AudioEngine::AudioEngine(QObject *parent)
+    : PlaybackBackend(parent)
+    , m_format(outputFormat())
+    , m_decks{ std::make_unique<RingBuffer>(RING_FRAMES, m_format.channelCount()),
+               std::make_unique<RingBuffer>(RING_FRAMES, m_format.channelCount()) }
+    , m_reader(new SinkReader(m_decks[0].get(), m_decks[1].get(), m_format, this))
+    , m_sink(new QAudioSink(QMediaDevices::defaultAudioOutput(), m_format, this))
+    , m_worker(nullptr)
+    , m_generation(0)
+    , m_decoding(false)
+    , m_queueDecoded(false)
+    , m_queueEndDeck(0)
+    , m_queueEnd(0)
+    , m_position(0)
+    , m_state(QMediaPlayer::StoppedState)
+{
+    m_reader->open(QIODevice::ReadOnly);
+    connect(m_sink, &QAudioSink::stateChanged, this, [this]() {
+        const QAudio::Error error = m_sink->error();
+        if (error == QAudio::OpenError || error == QAudio::FatalError) {
+            emit errorOccurred(QMediaPlayer::ResourceError, tr("Could not open the audio output"));
+            stop();
+        }
+    });
+
+    // The decoder always hands out floats; the reader converts if the
+    // device wants integers
+    QAudioFormat decodeFormat = m_format;
+    decodeFormat.setSampleFormat(QAudioFormat::Float);
+    m_worker = new DecodeWorker(m_decks[0].get(), m_decks[1].get(), m_reader, decodeFormat);
+    m_worker->moveToThread(&m_decoderThread);
+    connect(&m_decoderThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &DecodeWorker::entryStarted, this, &AudioEngine::onEntryStarted);
+    connect(m_worker, &DecodeWorker::durationKnown, this, &AudioEngine::onDurationKnown);
+    connect(m_worker, &DecodeWorker::failed, this, &AudioEngine::onFailed);
+    connect(m_worker, &DecodeWorker::finished, this, &AudioEngine::onFinished);
+    m_decoderThread.setObjectName(QStringLiteral("AudioDecoder"));
+    m_decoderThread.start(QThread::HighPriority);
+
+    m_clock.setInterval(CLOCK_INTERVAL);
+    connect(&m_clock, &QTimer::timeout, this, &AudioEngine::updateClock);
+
+    qCDebug(lcPlayback) << "Audio engine output format:" << m_format;
+}
+
+AudioEngine::~AudioEngine()
+{
+    m_sink->stop();
+    m_decoderThread.quit();
+    m_decoderThread.wait();
+}
+
+QAudioFormat AudioEngine::outputFormat()
+{
+    const QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    QAudioFormat format = device.preferredFormat();
+    if (!format.isValid()) {
+        format.setSampleRate(44100);
+        format.setChannelCount(2);
+    }
+    format.setSampleFormat(QAudioFormat::Float);
+    if (!device.isFormatSupported(format)) {
+        format.setSampleFormat(QAudioFormat::Int16);
+    }
+    return format;
+}
+
+QMediaPlayer::PlaybackState AudioEngine::playbackState() const
+{
+    return m_state;
+}
+
+qint64 AudioEngine::position() const
+{
+    return m_position;
+}
+
+qint64 AudioEngine::duration() const
+{
+    return m_entries.isEmpty() ? 0 : m_entries.first().duration;
+}
+
+QMediaMetaData AudioEngine::metaData() const
+{
+    // The decoder reads no tags; PlaybackCore has them from the library
+    return QMediaMetaData();
+}
+
+float AudioEngine::volume() const
+{
+    return m_reader->volume();
+}
+
+void AudioEngine::play()
+{
+    if (currentIndex() < 0) {
+        return;
+    }
+    if (!m_decoding) {
+        startDecoding(currentIndex(), 0);
+    }
+
+    if (m_state == QMediaPlayer::PausedState) {
+        m_sink->resume();
+    } else if (m_state == QMediaPlayer::StoppedState) {
+        m_sink->start(m_reader);
+    }
+    m_clock.start();
+    setState(QMediaPlayer::PlayingState);
+}
+
+void AudioEngine::pause()
+{
+    if (m_state == QMediaPlayer::PlayingState) {
+        m_sink->suspend();
+        m_clock.stop();
+        setState(QMediaPlayer::PausedState);
+    }
+}
+
+void AudioEngine::stop()
+{
+    m_sink->stop();
+    m_clock.stop();
+    stopDecoding();
+    m_position = 0;
+    emit positionChanged(m_position);
+    setState(QMediaPlayer::StoppedState);
+}
+
+void AudioEngine::setPosition(qint64 position)
+{
+    if (currentIndex() < 0) {
+        return;
+    }
+
+    // Keep the tags and duration; the worker only reads them from the start
+    if (!m_entries.isEmpty()) {
+        m_seeking = m_entries.first();
+    }
+    m_position = qMax<qint64>(position, 0);
+    startDecoding(currentIndex(), m_position);
+    emit positionChanged(m_position);
+}
+
+void AudioEngine::setVolume(float volume)
+{
+    m_reader->setVolume(volume);
+}
+
+void AudioEngine::setCrossfade(int msecs, CrossfadeCurve curve)
+{
+    PlaybackBackend::setCrossfade(msecs, curve);
+    DecodeWorker *worker = m_worker;
+    const int duration = crossfadeDuration();
+    QMetaObject::invokeMethod(worker, [worker, duration, curve]() {
+        worker->setCrossfade(duration, curve);
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::setReplayGainMode(ReplayGainMode mode)
+{
+    PlaybackBackend::setReplayGainMode(mode);
+    DecodeWorker *worker = m_worker;
+    const QList<float> entryGains = gains();
+    QMetaObject::invokeMethod(worker, [worker, entryGains]() {
+        worker->setGains(entryGains);
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::load(int index, bool play)
+{
+    if (index < 0) {
+        stop();
+        return;
+    }
+
+    m_seeking = Entry();
+    m_position = 0;
+    if (play && m_state == QMediaPlayer::PlayingState && crossfadeDuration() > 0) {
+        // Skipping while playing fades out of what is heard now
+        ++m_generation;
+        m_entries.clear();
+        m_queueDecoded = false;
+        m_decoding = true;
+
+        DecodeWorker *worker = m_worker;
+        const int generation = m_generation;
+        const QList<QUrl> entries = queue();
+        const QList<float> entryGains = gains();
+        QMetaObject::invokeMethod(worker, [worker, generation, entries, entryGains, index]() {
+            worker->crossfadeTo(generation, entries, entryGains, index);
+        }, Qt::QueuedConnection);
+    } else {
+        startDecoding(index, 0);
+    }
+    emit positionChanged(m_position);
+    emit durationChanged(0);
+
+    // Like QMediaPlayer, a new entry starts out stopped unless told to play;
+    // it is decoded ahead either way
+    if (play) {
+        this->play();
+    } else {
+        m_sink->stop();
+        m_clock.stop();
+        setState(QMediaPlayer::StoppedState);
+    }
+}
+
+void AudioEngine::startDecoding(int index, qint64 position)
+{
+    ++m_generation;
+    m_entries.clear();
+    m_queueDecoded = false;
+    m_decoding = true;
+
+    DecodeWorker *worker = m_worker;
+    const int generation = m_generation;
+    const QList<QUrl> entries = queue();
+    const QList<float> entryGains = gains();
+    QMetaObject::invokeMethod(worker, [worker, generation, entries, entryGains, index, position]() {
+        worker->start(generation, entries, entryGains, index, position);
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::stopDecoding()
+{
+    ++m_generation;
+    m_entries.clear();
+    m_queueDecoded = false;
+    m_decoding = false;
+
+    DecodeWorker *worker = m_worker;
+    QMetaObject::invokeMethod(worker, [worker]() {
+        worker->stop();
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::setState(QMediaPlayer::PlaybackState state)
+{
+    if (state != m_state) {
+        m_state = state;
+        emit playbackStateChanged(state);
+    }
+}
+
+QList<float> AudioEngine::gains() const
+{
+    QList<float> result;
+    result.reserve(queue().size());
+    for (int i = 0; i < queue().size(); ++i) {
+        result.append(replayGain(i));
+    }
+    return result;
+}
+
+quint64 AudioEngine::playedPosition(int deck) const
+{
+    // The sink has read further than what is audible by what it buffers
+    const quint64 read = m_decks[deck]->readPosition();
+    const quint64 buffered = quint64(qMax(m_sink->bufferSize() - m_sink->bytesFree(), qsizetype(0)))
+                             / m_format.bytesPerFrame();
+    return read > buffered ? read - buffered : 0;
+}
+
+void AudioEngine::updateClock()
+{
+    const quint64 played[2] = { playedPosition(0), playedPosition(1) };
+
+    // Move on to the latest entry the sink has started to play. Its audio
+    // follows the previous one's, or fades in over it, without a gap, so
+    // only the bookkeeping changes here
+    int reached = 0;
+    for (int i = 1; i < m_entries.size(); ++i) {
+        if (played[m_entries.at(i).deck] > m_entries.at(i).start) {
+            reached = i;
+        }
+    }
+    if (reached > 0) {
+        m_entries.remove(0, reached);
+        const Entry &entry = m_entries.first();
+        setCurrentEntry(entry.index);
+        emit durationChanged(entry.duration);
+    }
+
+    if (!m_entries.isEmpty()) {
+        const Entry &entry = m_entries.first();
+        const quint64 frames = played[entry.deck] > entry.start ? played[entry.deck] - entry.start : 0;
+        const qint64 position = entry.startPosition + qint64(frames * 1000 / quint64(m_format.sampleRate()));
+        if (position != m_position) {
+            m_position = position;
+            emit positionChanged(m_position);
+        }
+    }
+
+    if (m_queueDecoded && played[m_queueEndDeck] >= m_queueEnd) {
+        m_sink->stop();
+        m_clock.stop();
+        m_decoding = false;
+        setState(QMediaPlayer::StoppedState);
+    }
+}
+
+AudioEngine::Entry *AudioEngine::findEntry(int generation, int index)
+{
+    if (generation != m_generation) {
+        return nullptr;
+    }
+    for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it) {
+        if (it->index == index) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+void AudioEngine::onEntryStarted(int generation, int index, int deck, quint64 ringPosition, qint64 position)
+{
+    if (generation != m_generation) {
+        return;
+    }
+
+    Entry entry;
+    entry.index = index;
+    entry.deck = deck;
+    entry.start = ringPosition;
+    entry.startPosition = position;
+    if (m_entries.isEmpty() && m_seeking.index == index) {
+        entry.duration = m_seeking.duration;
+    }
+    m_entries.append(entry);
+}
+
+void AudioEngine::onDurationKnown(int generation, int index, qint64 duration)
+{
+    Entry *entry = findEntry(generation, index);
+    if (entry && entry->duration != duration) {
+        entry->duration = duration;
+        if (entry == &m_entries.first()) {
+            emit durationChanged(duration);
+        }
+    }
+}
+
+void AudioEngine::onFailed(int generation, int index, const QString &errorString)
+{
+    Q_UNUSED(index);
+    if (generation == m_generation) {
+        emit errorOccurred(QMediaPlayer::ResourceError, errorString);
+    }
+}
+
+void AudioEngine::onFinished(int generation, int deck, quint64 ringPosition)
+{
+    if (generation == m_generation) {
+        m_queueDecoded = true;
+        m_queueEndDeck = deck;
+        m_queueEnd = ringPosition;
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <QAudioFormat>
+#include <QAudioSink>
+#include <QThread>
+#include <QTimer>
+#include <memory>
+#include "playbackbackend.h"
+#include "ringbuffer.h"
+#include "sinkreader.h"
+
+class DecodeWorker;
+
+// Plays the queue through our own pipeline instead of QMediaPlayer: a
+// worker thread decodes into lock-free rings, one per deck, and a
+// QAudioSink drains them in pull mode through the mixing SinkReader.
+// Without a crossfade the worker decodes on into the next entry on the
+// same deck, so consecutive tracks are spliced at the sample; with one,
+// entries alternate decks and the reader fades between them. Positions
+// in the rings double as the clock: each entry records where its audio
+// starts on its deck, and the engine moves on to it once the sink has
+// read past that.
+class AudioEngine : public PlaybackBackend
+{
+    Q_OBJECT
+
+public:
+    explicit AudioEngine(QObject *parent = nullptr);
+    ~AudioEngine() override;
+
+    QMediaPlayer::PlaybackState playbackState() const override;
+    qint64 position() const override;
+    qint64 duration() const override;
+    QMediaMetaData metaData() const override;
+    float volume() const override;
+    bool canCrossfade() const override { return true; }
+
+public slots:
+    void play() override;
+    void pause() override;
+    void stop() override;
+    void setPosition(qint64 position) override;
+    void setVolume(float volume) override;
+    void setCrossfade(int msecs, CrossfadeCurve curve) override;
+    void setReplayGainMode(ReplayGainMode mode) override;
+
+protected:
+    void load(int index, bool play) override;
+
+private:
+    // An entry whose audio is in its deck's ring, or about to be
+    struct Entry
+    {
+        int index = -1;
+        int deck = 0;
+        quint64 start = 0;          // position of its first frame in the deck's ring
+        qint64 startPosition = 0;   // msecs into the track at that frame
+        qint64 duration = 0;
+    };
+
+    static QAudioFormat outputFormat();
+    void startDecoding(int index, qint64 position);
+    void stopDecoding();
+    void setState(QMediaPlayer::PlaybackState state);
+    QList<float> gains() const;
+    quint64 playedPosition(int deck) const;
+    void updateClock();
+    Entry *findEntry(int generation, int index);
+
+    void onEntryStarted(int generation, int index, int deck, quint64 ringPosition, qint64 position);
+    void onDurationKnown(int generation, int index, qint64 duration);
+    void onFailed(int generation, int index, const QString &errorString);
+    void onFinished(int generation, int deck, quint64 ringPosition);
+
+    QAudioFormat m_format;
+    std::unique_ptr<RingBuffer> m_decks[2];
+    SinkReader *m_reader;
+    QAudioSink *m_sink;
+    QThread m_decoderThread;
+    DecodeWorker *m_worker;
+    QTimer m_clock;
+    int m_generation;
+    bool m_decoding;
+    QList<Entry> m_entries;     // the current one first
+    Entry m_seeking;            // the entry a seek restarted, to keep its duration
+    bool m_queueDecoded;
+    int m_queueEndDeck;
+    quint64 m_queueEnd;         // ring position where the queue's audio ends
+    qint64 m_position;
+    QMediaPlayer::PlaybackState m_state;
+};
+
+#endif // AUDIOENGINE_H
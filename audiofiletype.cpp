@@ -0,0 +1,129 @@
+#include "audiofiletype.h"
+#include "logging.h"
+#include "trace.h"
+#include <QFile>
+#include <QHash>
+#include <QByteArray>
+
+namespace AudioFileType {
+
+namespace {
+    using ExtensionTable = QHash<QString, Kind>;
+
+    ExtensionTable buildExtensionTable()
+    {
+        ExtensionTable table;
+
+        const char *audio[] = {
+            "mp3", "mp2", "m4a", "m4b", "aac", "ogg", "oga", "opus", "flac",
+            "wav", "wma", "aif", "aiff", "aifc", "ape", "wv", "mpc", "mka",
+            "spx", "tta", "ac3", "dts", "caf", "amr", "au", "snd"
+        };
+        for (const char *ext : audio) {
+            table.insert(QString::fromLatin1(ext), Kind::Audio);
+        }
+
+        // Things that typically sit next to the music
+        const char *notAudio[] = {
+            "jpg", "jpeg", "png", "gif", "bmp", "webp", "tif", "tiff",
+            "cue", "log", "txt", "nfo", "md5", "sfv", "ffp", "accurip",
+            "m3u", "m3u8", "pls", "xspf", "pdf", "db", "ini", "lrc",
+            "mkv", "avi", "mov", "wmv", "webm", "ogv", "mpg", "mpeg",
+            "zip", "rar", "7z", "par2", "torrent", "html", "htm", "xml", "json"
+        };
+        for (const char *ext : notAudio) {
+            table.insert(QString::fromLatin1(ext), Kind::NotAudio);
+        }
+
+        table.insert(QStringLiteral("mp4"), Kind::Ambiguous);
+
+        return table;
+    }
+
+    const ExtensionTable &extensionTable()
+    {
+        static const ExtensionTable table = buildExtensionTable();
+        return table;
+    }
+
+    bool isMpegAudioSync(const QByteArray &header)
+    {
+        // 11-bit frame sync with a valid layer; also matches ADTS AAC
+        const uchar b0 = uchar(header.at(0));
+        const uchar b1 = uchar(header.at(1));
+        return b0 == 0xff && (b1 & 0xe0) == 0xe0 && (b1 & 0x06) != 0x00;
+    }
+}
+
+Kind classifyExtension(const QString &suffix)
+{
+    if (suffix.isEmpty()) {
+        return Kind::Unknown;
+    }
+    return extensionTable().value(suffix.toLower(), Kind::Unknown);
+}
+
+bool probe(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const QByteArray header = file.read(12);
+    if (header.size() < 4) {
+        return false;
+    }
+
+    if (header.startsWith("ID3") || header.startsWith("fLaC") || header.startsWith("OggS")
+        || header.startsWith("MAC ") || header.startsWith("wvpk") || header.startsWith("MPCK")
+        || header.startsWith("MP+") || header.startsWith("#!AMR") || header.startsWith(".snd")) {
+        return true;
+    }
+
+    if (isMpegAudioSync(header)) {
+        return true;
+    }
+
+    if (header.size() == 12) {
+        const QByteArray format = header.mid(8, 4);
+        if (header.startsWith("RIFF")) {
+            return format == "WAVE";
+        }
+        if (header.startsWith("FORM")) {
+            return format == "AIFF" || format == "AIFC";
+        }
+        if (header.mid(4, 4) == "ftyp") {
+            // Only the audio brands; plain isom/mp42 files are usually video
+            return format == "M4A " || format == "M4B " || format == "M4P " || format == "F4A ";
+        }
+    }
+
+    return false;
+}
+
+bool isAudioFile(const QFileInfo &fileInfo)
+{
+    TRACE_SCOPE("isAudioFile");
+    const Kind kind = classifyExtension(fileInfo.suffix());
+
+    bool audio;
+    switch (kind) {
+    case Kind::Audio:
+        audio = true;
+        break;
+    case Kind::NotAudio:
+        audio = false;
+        break;
+    default:
+        audio = probe(fileInfo.filePath());
+        break;
+    }
+
+    qCDebug(lcScan) << "Checking file:" << fileInfo.filePath()
+                    << (kind == Kind::Audio || kind == Kind::NotAudio ? "by extension" : "by content")
+                    << (audio ? "audio" : "not audio");
+    return audio;
+}
+
+}
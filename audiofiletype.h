@@ -0,0 +1,23 @@
+#ifndef AUDIOFILETYPE_H
+#define AUDIOFILETYPE_H
+
+#include <QFileInfo>
+#include <QString>
+
+// Decides whether a file is playable audio. The extension table answers
+// almost every case without touching the file; only unknown or ambiguous
+// extensions are opened for a magic-byte probe.
+namespace AudioFileType {
+    enum class Kind {
+        Audio,
+        NotAudio,
+        Ambiguous,  // e.g. .mp4, which may hold audio only or video
+        Unknown
+    };
+
+    Kind classifyExtension(const QString &suffix);
+    bool probe(const QString &filePath);
+    bool isAudioFile(const QFileInfo &fileInfo);
+}
+
+#endif // AUDIOFILETYPE_H
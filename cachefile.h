@@ -0,0 +1,86 @@
+#ifndef CACHEFILE_H
+#define CACHEFILE_H
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QString>
+
+// One directory under the cache location, holding a single T per key
+// behind a magic number and format version. T needs isNull() and the
+// QDataStream operators, and its reader must mark the stream corrupt
+// rather than trust sizes it reads. Safe to use from any thread.
+template <typename T>
+class CacheFile
+{
+public:
+    CacheFile(const QString &directory, const QString &suffix, quint32 magic, quint32 version)
+        : m_directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + '/' + directory)
+        , m_suffix(suffix)
+        , m_magic(magic)
+        , m_version(version)
+    {
+        QDir().mkpath(m_directory);
+    }
+
+    QString path(const QString &key) const
+    {
+        return m_directory + '/' + key + m_suffix;
+    }
+
+    bool contains(const QString &key) const
+    {
+        return QFile::exists(path(key));
+    }
+
+    bool store(const QString &key, const T &value) const
+    {
+        if (key.isEmpty() || value.isNull()) {
+            return false;
+        }
+
+        QSaveFile file(path(key));
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+
+        QDataStream out(&file);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << m_magic << m_version << value;
+        return file.commit();
+    }
+
+    // Null if not stored or unreadable
+    T load(const QString &key) const
+    {
+        QFile file(path(key));
+        if (!file.open(QIODevice::ReadOnly)) {
+            return T();
+        }
+
+        QDataStream in(&file);
+        in.setVersion(QDataStream::Qt_6_0);
+        quint32 magic = 0;
+        quint32 version = 0;
+        T value;
+        in >> magic >> version;
+        if (magic != m_magic || version != m_version) {
+            return T();
+        }
+        in >> value;
+        if (in.status() != QDataStream::Ok) {
+            return T();
+        }
+        return value;
+    }
+
+private:
+    const QString m_directory;
+    const QString m_suffix;
+    const quint32 m_magic;
+    const quint32 m_version;
+};
+
+#endif // CACHEFILE_H
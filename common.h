@@ -27,4 +27,15 @@ enum class PlaybackState {
     Paused
 };
 
+enum class CrossfadeCurve {
+    Linear,
+    EqualPower
+};
+
+enum class ReplayGainMode {
+    Off,
+    Track,
+    Album
+};
+
 #endif // COMMON_H 
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "coverstore.h"
+#include "trace.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QWaitCondition>
+
+namespace CoverStore {
+
+namespace {
+    constexpr quint32 RAW_MAGIC = 0x4d415254; // "MART"
+
+    QMutex storedMutex;
+    QWaitCondition storedCondition;
+    QSet<QString> storedKeys;   // written, or found on disk
+    QSet<QString> pendingKeys;  // being written by some thread
+
+    const QString &directory()
+    {
+        static const QString dir = [] {
+            const QString path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/covers";
+            QDir().mkpath(path);
+            return path;
+        }();
+        return dir;
+    }
+
+    QString masterPath(const QString &key)
+    {
+        return directory() + '/' + key + ".jpg";
+    }
+
+    QString thumbnailPath(const QString &key, int size)
+    {
+        return directory() + '/' + key + '-' + QString::number(size) + ".raw";
+    }
+
+    // Thumbnails are raw premultiplied pixels so loading one is a plain
+    // read rather than an image decode
+    bool writeRaw(const QString &fileName, const QImage &image)
+    {
+        const QImage pixels = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+        QSaveFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+
+        QDataStream out(&file);
+        out << RAW_MAGIC << quint32(pixels.width()) << quint32(pixels.height());
+        out.writeRawData(reinterpret_cast<const char *>(pixels.constBits()), int(pixels.sizeInBytes()));
+        return file.commit();
+    }
+
+    QImage readRaw(const QString &fileName)
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QImage();
+        }
+
+        QDataStream in(&file);
+        quint32 magic = 0;
+        quint32 width = 0;
+        quint32 height = 0;
+        in >> magic >> width >> height;
+        if (in.status() != QDataStream::Ok || magic != RAW_MAGIC
+            || width == 0 || height == 0 || width > 4096 || height > 4096) {
+            return QImage();
+        }
+
+        QImage image(int(width), int(height), QImage::Format_ARGB32_Premultiplied);
+        const int bytes = int(image.sizeInBytes());
+        if (in.readRawData(reinterpret_cast<char *>(image.bits()), bytes) != bytes) {
+            return QImage();
+        }
+        return image;
+    }
+
+    bool write(const QString &key, const QByteArray &data)
+    {
+        QImage image;
+        if (!image.loadFromData(data)) {
+            return false;
+        }
+
+        if (image.width() > MASTER_SIZE || image.height() > MASTER_SIZE) {
+            image = image.scaled(MASTER_SIZE, MASTER_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+
+        // Thumbnails first; the master's presence marks the key as complete
+        for (int size : THUMBNAIL_SIZES) {
+            writeRaw(thumbnailPath(key, size),
+                     image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        }
+        return image.save(masterPath(key), "JPG", 90);
+    }
+}
+
+bool isThumbnailSize(int size)
+{
+    for (int thumbnailSize : THUMBNAIL_SIZES) {
+        if (size == thumbnailSize) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool store(const QString &key, const QByteArray &data)
+{
+    TRACE_SCOPE("store cover");
+    if (key.isEmpty()) {
+        return false;
+    }
+
+    {
+        // Claim the key so concurrent readers of the same album write it
+        // once; they wait for it, so the files are there when they return
+        QMutexLocker locker(&storedMutex);
+        while (pendingKeys.contains(key)) {
+            storedCondition.wait(&storedMutex);
+        }
+        if (storedKeys.contains(key)) {
+            return true;
+        }
+        pendingKeys.insert(key);
+    }
+
+    const bool stored = QFile::exists(masterPath(key)) || write(key, data);
+
+    {
+        // A failure leaves the key free for the next track to try
+        QMutexLocker locker(&storedMutex);
+        pendingKeys.remove(key);
+        if (stored) {
+            storedKeys.insert(key);
+        }
+    }
+    storedCondition.wakeAll();
+    return stored;
+}
+
+QImage master(const QString &key)
+{
+    return QImage(masterPath(key));
+}
+
+QString masterFile(const QString &key)
+{
+    return masterPath(key);
+}
+
+QImage thumbnail(const QString &key, int size)
+{
+    return readRaw(thumbnailPath(key, size));
+}
+
+}
@@ -0,0 +1,27 @@
+#ifndef COVERSTORE_H
+#define COVERSTORE_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+
+// On-disk store of cover images keyed by the content hash of the embedded
+// picture. Each distinct picture is decoded and written once, however many
+// tracks embed it. Safe to call from any thread.
+namespace CoverStore {
+    constexpr int THUMBNAIL_SIZES[] = { 50, 60, 300 };
+    constexpr int MASTER_SIZE = 1024;
+
+    bool isThumbnailSize(int size);
+
+    // Decodes data and writes the master and thumbnails unless key is
+    // already stored. Returns false if the picture cannot be decoded.
+    bool store(const QString &key, const QByteArray &data);
+
+    QImage master(const QString &key);
+    // Where the master is kept, for front ends that load images by URL
+    QString masterFile(const QString &key);
+    QImage thumbnail(const QString &key, int size);
+}
+
+#endif // COVERSTORE_H
@@ -0,0 +1,390 @@
+#include "decodeworker.h"
+#include "sinkreader.h"
+#include "mixer.h"
+#include "seektablestore.h"
+#include "splicedfile.h"
+#include "logging.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QTimer>
+
+namespace {
+    // Long enough to let the output drain a little, short next to the
+    // ring's length
+    constexpr int RETRY_INTERVAL = 20;  // msecs
+}
+
+DecodeWorker::DecodeWorker(RingBuffer *deck0, RingBuffer *deck1, SinkReader *reader,
+                           const QAudioFormat &format, QObject *parent)
+    : QObject(parent)
+    , m_reader(reader)
+    , m_format(format)
+    , m_retry(nullptr)
+    , m_generation(0)
+    , m_lead(0)
+    , m_fadingOut(-1)
+    , m_request(0)
+    , m_crossfade(0)
+    , m_curve(CrossfadeCurve::EqualPower)
+{
+    m_decks[0].ring = deck0;
+    m_decks[1].ring = deck1;
+}
+
+void DecodeWorker::createDecoders()
+{
+    // Created on first use, so they belong to the decoder thread
+    if (m_retry) {
+        return;
+    }
+
+    for (int deck = 0; deck < 2; ++deck) {
+        QAudioDecoder *decoder = new QAudioDecoder(this);
+        decoder->setAudioFormat(m_format);
+        connect(decoder, &QAudioDecoder::bufferReady, this, &DecodeWorker::fill);
+        connect(decoder, &QAudioDecoder::finished, this, [this, deck]() {
+            m_decks[deck].atEnd = true;
+            fill();
+        });
+        connect(decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error),
+                this, [this, deck](QAudioDecoder::Error error) {
+            onError(deck, error);
+        });
+        connect(decoder, &QAudioDecoder::durationChanged, this, [this, deck](qint64 duration) {
+            // A spliced source reports the length of what is left, or of
+            // the whole file, depending on the format; its table knows
+            Deck &d = m_decks[deck];
+            if (d.index >= 0 && duration > 0 && !d.device) {
+                d.duration = duration * 1000;
+                emit durationKnown(m_generation, d.index, duration);
+            }
+        });
+        m_decks[deck].decoder = decoder;
+    }
+
+    m_retry = new QTimer(this);
+    m_retry->setSingleShot(true);
+    m_retry->setInterval(RETRY_INTERVAL);
+    connect(m_retry, &QTimer::timeout, this, &DecodeWorker::fill);
+}
+
+void DecodeWorker::start(int generation, const QList<QUrl> &queue, const QList<float> &gains,
+                         int index, qint64 position)
+{
+    createDecoders();
+    halt(0, true);
+    halt(1, true);
+    m_generation = generation;
+    m_queue = queue;
+    m_gains = gains;
+    m_fadingOut = -1;
+    if (index >= 0 && index < m_queue.size()) {
+        open(m_lead, index, position);
+    }
+    // Play the lead deck right away, dropping any fade under way
+    m_request = m_reader->requestSwitch(m_lead, 0, 0, m_curve);
+}
+
+void DecodeWorker::crossfadeTo(int generation, const QList<QUrl> &queue, const QList<float> &gains, int index)
+{
+    createDecoders();
+    const int out = m_lead;
+    const int in = m_lead ^ 1;
+    if (m_crossfade <= 0 || m_decks[out].index < 0 || m_fadingOut >= 0 || !readerIdle()
+            || index < 0 || index >= queue.size()) {
+        start(generation, queue, gains, index, 0);
+        return;
+    }
+
+    m_generation = generation;
+    m_queue = queue;
+    m_gains = gains;
+    halt(in, true);
+    open(in, index, 0);
+    m_fadingOut = out;
+    m_request = m_reader->requestSwitch(in, 0, m_format.framesForDuration(qint64(m_crossfade) * 1000), m_curve);
+}
+
+void DecodeWorker::setCrossfade(int msecs, CrossfadeCurve curve)
+{
+    m_crossfade = msecs;
+    m_curve = curve;
+}
+
+void DecodeWorker::setGains(const QList<float> &gains)
+{
+    m_gains = gains;
+    for (Deck &d : m_decks) {
+        if (d.index >= 0) {
+            d.gain = m_gains.value(d.index, 1.0f);
+        }
+    }
+}
+
+void DecodeWorker::stop()
+{
+    if (m_retry) {
+        m_retry->stop();
+    }
+    halt(0, true);
+    halt(1, true);
+    m_fadingOut = -1;
+}
+
+void DecodeWorker::open(int deck, int index, qint64 position)
+{
+    // Whatever is still in the ring plays first; callers discard it when
+    // it should not
+    Deck &d = m_decks[deck];
+    d.decoder->stop();
+    closeDevice(deck);
+    d.buffer = QAudioBuffer();
+    d.offset = 0;
+    d.index = index;
+    d.gain = m_gains.value(index, 1.0f);
+    d.atEnd = false;
+    d.duration = 0;
+    d.skipUntil = position * 1000;
+    m_lead = deck;
+
+    const QUrl &url = m_queue.at(index);
+    emit entryStarted(m_generation, index, deck, d.ring->writePosition(), position);
+
+    if (position > 0 && url.isLocalFile() && openAt(deck, url.toLocalFile(), position)) {
+        d.decoder->setSourceDevice(d.device);
+    } else {
+        d.decoder->setSource(url);
+    }
+    d.decoder->start();
+}
+
+bool DecodeWorker::openAt(int deck, const QString &filePath, qint64 position)
+{
+    // Built here on the first seek into a file the loudness analysis has
+    // not reached yet; a walk over the frame headers, no decoding
+    const QFileInfo fileInfo(filePath);
+    const SeekTable table = SeekTableStore::get(filePath, fileInfo.size(),
+                                                fileInfo.lastModified().toMSecsSinceEpoch());
+    if (table.isNull() || table.sampleCount() <= 0) {
+        return false;
+    }
+    const SeekTable::Point point = table.find(position * table.sampleRate() / 1000);
+    if (point.offset <= 0) {
+        return false;
+    }
+
+    SplicedFile *device = new SplicedFile(filePath, table.headerSize(), point.offset, this);
+    if (!device->open(QIODevice::ReadOnly)) {
+        delete device;
+        return false;
+    }
+
+    Deck &d = m_decks[deck];
+    d.device = device;
+    d.startTime = point.sample * 1000000 / table.sampleRate();
+    d.timeBase = -1;
+    d.duration = table.sampleCount() * 1000000 / table.sampleRate();
+    emit durationKnown(m_generation, d.index, d.duration / 1000);
+    qCDebug(lcPlayback) << "Seeking to" << position << "ms from sample" << point.sample << "of" << filePath;
+    return true;
+}
+
+void DecodeWorker::closeDevice(int deck)
+{
+    Deck &d = m_decks[deck];
+    if (!d.device) {
+        return;
+    }
+    // The decoder is stopped; let go of the device before it goes
+    d.decoder->setSource(QUrl());
+    d.device->deleteLater();
+    d.device = nullptr;
+    d.startTime = 0;
+    d.timeBase = -1;
+}
+
+void DecodeWorker::halt(int deck, bool discard)
+{
+    Deck &d = m_decks[deck];
+    if (d.decoder) {
+        d.decoder->stop();
+        closeDevice(deck);
+    }
+    d.buffer = QAudioBuffer();
+    d.offset = 0;
+    d.index = -1;
+    d.atEnd = false;
+    d.duration = 0;
+    d.skipUntil = 0;
+    if (discard) {
+        // Nothing more of the old audio gets written after this
+        d.ring->discard();
+    }
+}
+
+void DecodeWorker::fill()
+{
+    // Once the reader is done fading, the old deck's leftovers can go
+    if (m_fadingOut >= 0 && readerIdle()) {
+        halt(m_fadingOut, true);
+        m_fadingOut = -1;
+    }
+    fillDeck(0);
+    fillDeck(1);
+}
+
+void DecodeWorker::fillDeck(int deck)
+{
+    Deck &d = m_decks[deck];
+    while (d.index >= 0) {
+        if (!d.buffer.isValid() && !takeBuffer(deck)) {
+            if (d.atEnd) {
+                endOfEntry(deck);
+                continue;
+            }
+            return;     // bufferReady calls again
+        }
+
+        const qsizetype frames = d.buffer.frameCount() - d.offset;
+        const float *data = d.buffer.constData<float>() + d.offset * m_format.channelCount();
+        d.offset += d.ring->write(data, frames);
+        if (d.offset < d.buffer.frameCount()) {
+            m_retry->start();
+            return;
+        }
+        d.buffer = QAudioBuffer();
+    }
+}
+
+bool DecodeWorker::takeBuffer(int deck)
+{
+    Deck &d = m_decks[deck];
+    while (d.decoder->bufferAvailable()) {
+        // Reading is what lets the decoder go on to the next buffer
+        QAudioBuffer buffer = d.decoder->read();
+        if (!buffer.isValid() || buffer.frameCount() == 0) {
+            continue;
+        }
+
+        const QAudioFormat format = buffer.format();
+        if (format.sampleFormat() != QAudioFormat::Float
+                || format.channelCount() != m_format.channelCount()
+                || format.sampleRate() != m_format.sampleRate()) {
+            emit failed(m_generation, d.index, tr("Decoder produced an unsupported audio format"));
+            d.decoder->stop();
+            d.atEnd = true;
+            return false;
+        }
+
+        // Seeking decodes from the start, or the nearest seek point, and
+        // drops what comes before the target
+        const qint64 start = entryTime(deck, buffer);
+        qsizetype offset = 0;
+        if (d.skipUntil > 0) {
+            if (start + buffer.duration() <= d.skipUntil) {
+                continue;
+            }
+            if (start < d.skipUntil) {
+                offset = m_format.framesForDuration(d.skipUntil - start);
+            }
+            d.skipUntil = 0;
+        }
+
+        if (d.gain != 1.0f) {
+            Mixer::scale(buffer.data<float>(), buffer.sampleCount(), d.gain);
+        }
+        d.buffer = buffer;
+        d.offset = offset;
+        if (deck == m_lead) {
+            planFade(deck, buffer, start, offset);
+        }
+        return true;
+    }
+    return false;
+}
+
+qint64 DecodeWorker::entryTime(int deck, const QAudioBuffer &buffer)
+{
+    // Depending on the format, a spliced source's timestamps start at zero
+    // or carry on from the frame numbers; only the distance from its first
+    // buffer is relied on
+    Deck &d = m_decks[deck];
+    if (!d.device) {
+        return buffer.startTime();
+    }
+    if (d.timeBase < 0) {
+        d.timeBase = buffer.startTime();
+    }
+    return buffer.startTime() - d.timeBase + d.startTime;
+}
+
+void DecodeWorker::planFade(int deck, const QAudioBuffer &buffer, qint64 time, qsizetype offset)
+{
+    const Deck &d = m_decks[deck];
+    const int other = deck ^ 1;
+    if (m_crossfade <= 0 || d.duration <= 0 || d.index + 1 >= m_queue.size()) {
+        return;
+    }
+
+    const qint64 fadeStart = qMax<qint64>(d.duration - qint64(m_crossfade) * 1000, 0);
+    const qint64 start = time + m_format.durationForFrames(offset);
+    if (time + buffer.duration() <= fadeStart) {
+        return;
+    }
+    // Still fading out of the last change; this entry ends without a fade,
+    // or a shorter one if the other deck frees up in time
+    if (m_decks[other].index >= 0 || m_fadingOut >= 0 || !readerIdle()) {
+        return;
+    }
+
+    const qint64 from = qMax(fadeStart, start);
+    const qsizetype length = m_format.framesForDuration(d.duration - from);
+    if (length <= 0) {
+        return;
+    }
+    // The buffer is about to be written at the ring's write position
+    const quint64 marker = d.ring->writePosition() + quint64(m_format.framesForDuration(from - start));
+    const int next = d.index + 1;
+
+    halt(other, true);
+    open(other, next, 0);
+    m_fadingOut = deck;
+    m_request = m_reader->requestSwitch(other, marker, length, m_curve);
+    qCDebug(lcPlayback) << "Crossfading into entry" << next << "over" << length << "frames";
+}
+
+void DecodeWorker::endOfEntry(int deck)
+{
+    Deck &d = m_decks[deck];
+    if (deck != m_lead) {
+        // The deck fading out ran dry; the reader plays out what it has
+        halt(deck, false);
+        return;
+    }
+    if (d.index + 1 < m_queue.size()) {
+        open(deck, d.index + 1, 0);
+        return;
+    }
+
+    emit finished(m_generation, deck, d.ring->writePosition());
+    halt(deck, false);
+}
+
+void DecodeWorker::onError(int deck, QAudioDecoder::Error error)
+{
+    Deck &d = m_decks[deck];
+    if (d.index < 0) {
+        return;
+    }
+    qCWarning(lcPlayback) << "Could not decode" << m_queue.at(d.index) << error << d.decoder->errorString();
+    emit failed(m_generation, d.index, d.decoder->errorString());
+
+    // Go on with whatever was decoded, then the next entry
+    d.atEnd = true;
+    fill();
+}
+
+bool DecodeWorker::readerIdle() const
+{
+    return m_reader->completedRequest() == m_request;
+}
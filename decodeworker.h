@@ -0,0 +1,109 @@
+#ifndef DECODEWORKER_H
+#define DECODEWORKER_H
+
+#include <QObject>
+#include <QAudioBuffer>
+#include <QAudioDecoder>
+#include <QAudioFormat>
+#include <QList>
+#include <QUrl>
+#include "common.h"
+#include "ringbuffer.h"
+
+class QTimer;
+class SinkReader;
+class SplicedFile;
+
+// Lives on the engine's decoder thread and keeps the two decks' rings
+// filled. Without a crossfade, entries are decoded back to back on one
+// deck, from the start index to the end of the queue, so the first
+// sample of the next track lands right after the last one of the current.
+// With a crossfade, the next entry is opened on the other deck once the
+// current one is within the fade of its end, and the reader is asked to
+// fade over at that point. Decoding is paced by the rings: a buffer is
+// only taken from a decoder once the previous one fits.
+//
+// A seek into an MP3 or FLAC starts the decoder at the nearest point of
+// the file's seek table, through a SplicedFile, and drops the few
+// hundred milliseconds up to the target; other formats are decoded from
+// the start up to it.
+//
+// Each entry's ReplayGain is applied as its buffers come off the decoder,
+// so it changes exactly at the entry boundary.
+//
+// Every start is tagged with a generation, and every signal carries it,
+// so the engine can drop reports about audio it has already discarded.
+class DecodeWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    DecodeWorker(RingBuffer *deck0, RingBuffer *deck1, SinkReader *reader,
+                 const QAudioFormat &format, QObject *parent = nullptr);
+
+public slots:
+    // Discards what is in the rings and decodes queue from index, starting
+    // position msecs into that entry. gains has one per queue entry
+    void start(int generation, const QList<QUrl> &queue, const QList<float> &gains, int index, qint64 position);
+    // Fades from what is playing into index; cuts over like start() if a
+    // fade is already under way
+    void crossfadeTo(int generation, const QList<QUrl> &queue, const QList<float> &gains, int index);
+    void setCrossfade(int msecs, CrossfadeCurve curve);
+    // New gains for the same queue; audio already in the rings keeps its own
+    void setGains(const QList<float> &gains);
+    void stop();
+
+signals:
+    // ringPosition is where the entry's first frame is in deck's ring
+    void entryStarted(int generation, int index, int deck, quint64 ringPosition, qint64 position);
+    void durationKnown(int generation, int index, qint64 duration);
+    void failed(int generation, int index, const QString &errorString);
+    // The queue is decoded up to ringPosition in deck's ring
+    void finished(int generation, int deck, quint64 ringPosition);
+
+private:
+    struct Deck
+    {
+        RingBuffer *ring = nullptr;
+        QAudioDecoder *decoder = nullptr;
+        int index = -1;             // -1 when idle
+        float gain = 1.0f;
+        bool atEnd = false;         // the decoder has no more buffers for index
+        qint64 duration = 0;        // usecs, 0 until known
+        qint64 skipUntil = 0;       // usecs to drop at the start of a seek
+        SplicedFile *device = nullptr;  // the source when started at a seek point
+        qint64 startTime = 0;       // usecs into the entry the source starts at
+        qint64 timeBase = -1;       // decoder time of its first buffer, -1 until seen
+        QAudioBuffer buffer;        // partly written buffer
+        qsizetype offset = 0;       // frames of buffer already written
+    };
+
+    void createDecoders();
+    void open(int deck, int index, qint64 position);
+    bool openAt(int deck, const QString &filePath, qint64 position);
+    void closeDevice(int deck);
+    void halt(int deck, bool discard);
+    void fill();
+    void fillDeck(int deck);
+    bool takeBuffer(int deck);
+    qint64 entryTime(int deck, const QAudioBuffer &buffer);
+    void planFade(int deck, const QAudioBuffer &buffer, qint64 time, qsizetype offset);
+    void endOfEntry(int deck);
+    void onError(int deck, QAudioDecoder::Error error);
+    bool readerIdle() const;
+
+    Deck m_decks[2];
+    SinkReader *m_reader;
+    QAudioFormat m_format;
+    QTimer *m_retry;            // polls for room while a ring is full
+    int m_generation;
+    QList<QUrl> m_queue;
+    QList<float> m_gains;
+    int m_lead;                 // deck holding the newest entry
+    int m_fadingOut;            // deck being faded out, -1 for none
+    quint32 m_request;          // last switch requested from the reader
+    int m_crossfade;            // msecs, 0 for none
+    CrossfadeCurve m_curve;
+};
+
+#endif // DECODEWORKER_H
@@ -0,0 +1,189 @@
+#include "directoryscanner.h"
+#include "trace.h"
+#include <QDirIterator>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <atomic>
+
+namespace {
+    constexpr int FLUSH_INTERVAL_MS = 100;
+}
+
+// Shared between the GUI thread and the pool jobs of one scan. A cancelled
+// scan keeps its state alive until its last running job returns.
+struct DirectoryScanner::ScanState
+{
+    DirectoryScanner::FileFilter filter;
+    std::atomic<bool> cancelled{false};
+    std::atomic<int> pending{0};
+    std::atomic<int> scanned{0};
+    std::atomic<int> queued{0};
+
+    QMutex mutex;
+    QFileInfoList found;
+    QStringList directories;
+};
+
+DirectoryScanner::DirectoryScanner(QObject *parent)
+    : QObject(parent)
+{
+    // Directory listing is I/O bound, so allow more jobs than cores for slow
+    // network mounts
+    m_pool.setMaxThreadCount(qBound(4, QThread::idealThreadCount() * 2, 16));
+
+    m_flushTimer.setInterval(FLUSH_INTERVAL_MS);
+    connect(&m_flushTimer, &QTimer::timeout, this, &DirectoryScanner::flush);
+}
+
+DirectoryScanner::~DirectoryScanner()
+{
+    abort();
+    m_pool.waitForDone();
+}
+
+void DirectoryScanner::setFilter(const FileFilter &filter)
+{
+    m_filter = filter;
+}
+
+void DirectoryScanner::start(const QStringList &roots)
+{
+    abort();
+
+    m_state = std::make_shared<ScanState>();
+    m_state->filter = m_filter;
+
+    for (const QString &root : roots) {
+        submit(&m_pool, m_state, root);
+    }
+
+    m_flushTimer.start();
+}
+
+void DirectoryScanner::add(const QStringList &roots)
+{
+    if (!m_state) {
+        start(roots);
+        return;
+    }
+
+    for (const QString &root : roots) {
+        submit(&m_pool, m_state, root);
+    }
+}
+
+void DirectoryScanner::cancel()
+{
+    if (m_state) {
+        abort();
+        emit finished(true);
+    }
+}
+
+void DirectoryScanner::abort()
+{
+    if (m_state) {
+        m_state->cancelled = true;
+        m_state.reset();
+    }
+    // Queued jobs are dropped; running ones see the flag and return early
+    m_pool.clear();
+    m_flushTimer.stop();
+}
+
+bool DirectoryScanner::isRunning() const
+{
+    return m_state != nullptr;
+}
+
+int DirectoryScanner::directoriesScanned() const
+{
+    return m_state ? m_state->scanned.load() : 0;
+}
+
+int DirectoryScanner::directoriesQueued() const
+{
+    return m_state ? m_state->queued.load() : 0;
+}
+
+void DirectoryScanner::submit(QThreadPool *pool, const std::shared_ptr<ScanState> &state, const QString &path)
+{
+    state->pending++;
+    state->queued++;
+    pool->start([pool, state, path]() {
+        scanDirectory(pool, state, path);
+    });
+}
+
+void DirectoryScanner::scanDirectory(QThreadPool *pool, const std::shared_ptr<ScanState> &state, const QString &path)
+{
+    TRACE_SCOPE("scan directory");
+    if (!state->cancelled) {
+        QFileInfoList files;
+        QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+        while (it.hasNext() && !state->cancelled) {
+            it.next();
+            QFileInfo entry = it.fileInfo();
+            if (entry.isDir()) {
+                // Subdirectories become their own jobs so idle workers pick
+                // them up in parallel
+                submit(pool, state, entry.filePath());
+            } else if (!state->filter || state->filter(entry)) {
+                // Stat here so size and mtime are cached before the GUI
+                // thread looks at them
+                entry.stat();
+                files.append(entry);
+            }
+        }
+
+        {
+            QMutexLocker locker(&state->mutex);
+            state->directories.append(path);
+            state->found.append(files);
+        }
+        state->scanned++;
+    }
+
+    // Children were counted before this decrement, so zero means done
+    state->pending--;
+}
+
+void DirectoryScanner::flush()
+{
+    if (!m_state) {
+        m_flushTimer.stop();
+        return;
+    }
+
+    std::shared_ptr<ScanState> state = m_state;
+    const bool done = state->pending == 0;
+
+    QFileInfoList batch;
+    QStringList directories;
+    {
+        QMutexLocker locker(&state->mutex);
+        batch.swap(state->found);
+        directories.swap(state->directories);
+    }
+
+    if (!directories.isEmpty()) {
+        emit directoriesFound(directories);
+    }
+    if (!batch.isEmpty() && m_state == state) {
+        emit filesFound(batch);
+    }
+
+    // A slot above may have cancelled or restarted the scan
+    if (m_state != state) {
+        return;
+    }
+
+    emit progressChanged(state->scanned, state->queued);
+
+    if (done) {
+        m_flushTimer.stop();
+        m_state.reset();
+        emit finished(false);
+    }
+}
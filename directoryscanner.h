@@ -0,0 +1,55 @@
+#ifndef DIRECTORYSCANNER_H
+#define DIRECTORYSCANNER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QTimer>
+#include <functional>
+#include <memory>
+
+// Walks directory trees on a thread pool, one job per directory, and hands
+// matching files back to the GUI thread in batches
+class DirectoryScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    using FileFilter = std::function<bool(const QFileInfo &)>;
+
+    explicit DirectoryScanner(QObject *parent = nullptr);
+    ~DirectoryScanner();
+
+    void setFilter(const FileFilter &filter);
+
+    void start(const QStringList &roots);
+    // Adds roots to the running scan, or starts a new one
+    void add(const QStringList &roots);
+    void cancel();
+    bool isRunning() const;
+
+    int directoriesScanned() const;
+    int directoriesQueued() const;
+
+signals:
+    void filesFound(const QFileInfoList &files);
+    void directoriesFound(const QStringList &directories);
+    void progressChanged(int directoriesScanned, int directoriesQueued);
+    void finished(bool cancelled);
+
+private:
+    struct ScanState;
+
+    static void submit(QThreadPool *pool, const std::shared_ptr<ScanState> &state, const QString &path);
+    static void scanDirectory(QThreadPool *pool, const std::shared_ptr<ScanState> &state, const QString &path);
+    void abort();
+    void flush();
+
+    FileFilter m_filter;
+    QThreadPool m_pool;
+    QTimer m_flushTimer;
+    std::shared_ptr<ScanState> m_state;
+};
+
+#endif // DIRECTORYSCANNER_H
@@ -0,0 +1,51 @@
+#include "filedecoder.h"
+#include <QAudioDecoder>
+#include <QEventLoop>
+#include <QUrl>
+
+bool FileDecoder::decode(const QString &filePath, const QAudioFormat &format,
+                         const std::function<bool(const QAudioBuffer &)> &consume,
+                         QString *errorString)
+{
+    QAudioDecoder decoder;
+    decoder.setAudioFormat(format);
+    decoder.setSource(QUrl::fromLocalFile(filePath));
+
+    QEventLoop loop;
+    bool done = false;
+    bool ok = true;
+    QString error;
+    const auto finish = [&](bool success) {
+        ok = ok && success;
+        done = true;
+        decoder.stop();
+        loop.quit();
+    };
+
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, &loop, [&]() {
+        while (!done && decoder.bufferAvailable()) {
+            const QAudioBuffer buffer = decoder.read();
+            if (buffer.isValid() && buffer.frameCount() > 0 && !consume(buffer)) {
+                finish(false);
+            }
+        }
+    });
+    QObject::connect(&decoder, &QAudioDecoder::finished, &loop, [&]() {
+        finish(true);
+    });
+    QObject::connect(&decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), &loop, [&]() {
+        error = decoder.errorString();
+        finish(false);
+    });
+
+    // Errors can be reported before start() returns
+    decoder.start();
+    if (!done) {
+        loop.exec();
+    }
+
+    if (errorString) {
+        *errorString = error;
+    }
+    return ok;
+}
@@ -0,0 +1,21 @@
+#ifndef FILEDECODER_H
+#define FILEDECODER_H
+
+#include <QAudioBuffer>
+#include <QAudioFormat>
+#include <QString>
+#include <functional>
+
+// Decodes a whole file on the calling thread for background analysis.
+// QAudioDecoder needs an event loop, so one runs here until the file is
+// done; any worker thread can call this.
+namespace FileDecoder {
+    // Hands each buffer to consume, which returns false to stop early.
+    // True if the file was decoded to the end; otherwise errorString, if
+    // given, says why (empty when consume stopped it).
+    bool decode(const QString &filePath, const QAudioFormat &format,
+                const std::function<bool(const QAudioBuffer &)> &consume,
+                QString *errorString = nullptr);
+}
+
+#endif // FILEDECODER_H
@@ -0,0 +1,104 @@
+#include "framescheduler.h"
+#include "logging.h"
+#include <QEvent>
+#include <QScreen>
+#include <QWidget>
+
+namespace {
+    constexpr int REPORT_INTERVAL = 5000;   // msecs
+}
+
+FrameScheduler::FrameScheduler(QWidget *window)
+    : QObject(window)
+    , m_window(window)
+    , m_pending(false)
+    , m_requests(0)
+    , m_frames(0)
+    , m_totalTime(0)
+    , m_worstTime(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &FrameScheduler::runFrame);
+    m_window->installEventFilter(this);
+}
+
+void FrameScheduler::schedule()
+{
+    ++m_requests;
+    m_pending = true;
+    start();
+}
+
+bool FrameScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_window) {
+        switch (event->type()) {
+        case QEvent::Show:
+        case QEvent::Hide:
+        case QEvent::WindowStateChange:
+            if (!isShown()) {
+                m_timer.stop();
+            } else if (m_pending) {
+                start();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+bool FrameScheduler::isShown() const
+{
+    return m_window->isVisible() && !m_window->isMinimized();
+}
+
+int FrameScheduler::frameInterval() const
+{
+    const QScreen *screen = m_window->screen();
+    const qreal rate = screen ? screen->refreshRate() : 60.0;
+    return qMax(1, qRound(1000.0 / (rate > 0 ? rate : 60.0)));
+}
+
+void FrameScheduler::start()
+{
+    if (m_timer.isActive() || !isShown()) {
+        return;
+    }
+    // A frame after a quiet spell goes out right away; otherwise it waits
+    // out the rest of the current one
+    const qint64 since = m_lastFrame.isValid() ? m_lastFrame.elapsed() : frameInterval();
+    m_timer.start(int(qMax<qint64>(frameInterval() - since, 0)));
+}
+
+void FrameScheduler::runFrame()
+{
+    if (!m_pending || !isShown()) {
+        return;
+    }
+    m_pending = false;
+    m_lastFrame.start();
+
+    QElapsedTimer timer;
+    timer.start();
+    emit frame();
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    ++m_frames;
+    m_totalTime += elapsed;
+    m_worstTime = qMax(m_worstTime, elapsed);
+    if (!m_reportTimer.isValid()) {
+        m_reportTimer.start();
+    } else if (m_reportTimer.elapsed() >= REPORT_INTERVAL) {
+        qCDebug(lcUi) << m_frames << "frames for" << m_requests << "requests in"
+                      << m_reportTimer.elapsed() << "ms, average" << m_totalTime / m_frames / 1000
+                      << "us, worst" << m_worstTime / 1000 << "us";
+        m_reportTimer.start();
+        m_requests = 0;
+        m_frames = 0;
+        m_totalTime = 0;
+        m_worstTime = 0;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+class QWidget;
+
+// Coalesces requests to refresh the UI from playback state into at most
+// one frame() per display refresh. Sources just call schedule() when
+// something changed; whatever is connected to frame() reads the latest
+// state and updates its widgets. Nothing runs while the window is hidden
+// or minimized; a request made meanwhile is served when it comes back.
+//
+// How long frames take is logged every few seconds under muse.ui.
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FrameScheduler(QWidget *window);
+
+    void schedule();
+
+signals:
+    void frame();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    bool isShown() const;
+    int frameInterval() const;
+    void start();
+    void runFrame();
+
+    QWidget *m_window;
+    QTimer m_timer;
+    QElapsedTimer m_lastFrame;
+    bool m_pending;
+
+    // Since the last report
+    QElapsedTimer m_reportTimer;
+    int m_requests;
+    int m_frames;
+    qint64 m_totalTime;     // nsecs
+    qint64 m_worstTime;     // nsecs
+};
+
+#endif // FRAMESCHEDULER_H
@@ -0,0 +1,223 @@
+#include "gaplessplayer.h"
+#include "logging.h"
+#include <QTimer>
+
+GaplessPlayer::GaplessPlayer(QObject *parent)
+    : PlaybackBackend(parent)
+    , m_active(0)
+    , m_preloaded(-1)
+    , m_volume(1.0f)
+    , m_state(QMediaPlayer::StoppedState)
+{
+    setupDeck(0);
+    setupDeck(1);
+}
+
+void GaplessPlayer::setupDeck(int deck)
+{
+    QMediaPlayer *player = new QMediaPlayer(this);
+    QAudioOutput *output = new QAudioOutput(this);
+    player->setAudioOutput(output);
+    m_players[deck] = player;
+    m_outputs[deck] = output;
+
+    // The standby deck reports its own load and stop; only the active one
+    // speaks for the player
+    connect(player, &QMediaPlayer::positionChanged, this, [this, player](qint64 position) {
+        if (player == active()) {
+            emit positionChanged(position);
+        }
+    });
+    connect(player, &QMediaPlayer::durationChanged, this, [this, player](qint64 duration) {
+        if (player == active()) {
+            emit durationChanged(duration);
+        }
+    });
+    connect(player, &QMediaPlayer::metaDataChanged, this, [this, player]() {
+        if (player == active()) {
+            emit metaDataChanged();
+        }
+    });
+    connect(player, &QMediaPlayer::mediaStatusChanged, this, [this, player](QMediaPlayer::MediaStatus status) {
+        if (player == active()) {
+            onMediaStatusChanged(status);
+        }
+    });
+    connect(player, &QMediaPlayer::playbackStateChanged, this, [this, player](QMediaPlayer::PlaybackState state) {
+        if (player == active()) {
+            onPlaybackStateChanged(state);
+        }
+    });
+    connect(player, &QMediaPlayer::errorOccurred, this,
+            [this, player](QMediaPlayer::Error error, const QString &errorString) {
+        if (player == active()) {
+            emit errorOccurred(error, errorString);
+            return;
+        }
+        // The entry will be opened again, and fail visibly, when it is reached
+        qCWarning(lcPlayback) << "Could not preload" << player->source() << errorString;
+        m_preloaded = -1;
+    });
+}
+
+QMediaPlayer::PlaybackState GaplessPlayer::playbackState() const
+{
+    return m_state;
+}
+
+qint64 GaplessPlayer::position() const
+{
+    return active()->position();
+}
+
+qint64 GaplessPlayer::duration() const
+{
+    return active()->duration();
+}
+
+QMediaMetaData GaplessPlayer::metaData() const
+{
+    return active()->metaData();
+}
+
+float GaplessPlayer::volume() const
+{
+    return m_volume;
+}
+
+void GaplessPlayer::play()
+{
+    if (currentIndex() >= 0) {
+        active()->play();
+    }
+}
+
+void GaplessPlayer::pause()
+{
+    active()->pause();
+}
+
+void GaplessPlayer::stop()
+{
+    active()->stop();
+}
+
+void GaplessPlayer::setPosition(qint64 position)
+{
+    active()->setPosition(position);
+}
+
+void GaplessPlayer::setVolume(float volume)
+{
+    m_volume = volume;
+    applyGain();
+}
+
+void GaplessPlayer::setReplayGainMode(ReplayGainMode mode)
+{
+    PlaybackBackend::setReplayGainMode(mode);
+    applyGain();
+}
+
+void GaplessPlayer::applyGain()
+{
+    // Each deck is leveled for the entry it holds. The outputs cannot go
+    // above unity, so boosts are lost here; cuts are what matter most
+    m_outputs[m_active]->setVolume(qMin(m_volume * replayGain(currentIndex()), 1.0f));
+    m_outputs[m_active ^ 1]->setVolume(qMin(m_volume * replayGain(m_preloaded), 1.0f));
+}
+
+QMediaPlayer *GaplessPlayer::active() const
+{
+    return m_players[m_active];
+}
+
+QMediaPlayer *GaplessPlayer::standby() const
+{
+    return m_players[m_active ^ 1];
+}
+
+void GaplessPlayer::onMediaStatusChanged(QMediaPlayer::MediaStatus status)
+{
+    if (status == QMediaPlayer::EndOfMedia && hasNext()) {
+        changeEntry(currentIndex() + 1, true);
+    }
+}
+
+void GaplessPlayer::onPlaybackStateChanged(QMediaPlayer::PlaybackState state)
+{
+    // A deck stops on its own at the end of a track, just before the next
+    // one takes over; settle the state after that so the front ends never
+    // see a stop between two queue entries
+    if (state == QMediaPlayer::StoppedState && hasNext()) {
+        QTimer::singleShot(0, this, &GaplessPlayer::updateState);
+        return;
+    }
+    updateState();
+}
+
+void GaplessPlayer::updateState()
+{
+    const QMediaPlayer::PlaybackState state = active()->playbackState();
+    if (state != m_state) {
+        m_state = state;
+        emit playbackStateChanged(state);
+    }
+}
+
+void GaplessPlayer::load(int index, bool play)
+{
+    if (index < 0) {
+        active()->stop();
+        active()->setSource(QUrl());
+    } else if (index == m_preloaded && standby()->source() == queue().at(index)) {
+        swapDecks(play);
+    } else {
+        active()->setSource(queue().at(index));
+        if (play) {
+            active()->play();
+        }
+    }
+    preload();
+    applyGain();
+}
+
+void GaplessPlayer::preload()
+{
+    const int next = currentIndex() + 1;
+    if (!hasNext()) {
+        // Nothing to open; let go of the previous file
+        m_preloaded = -1;
+        if (!standby()->source().isEmpty()) {
+            standby()->setSource(QUrl());
+        }
+        return;
+    }
+
+    if (standby()->source() != queue().at(next)) {
+        standby()->setSource(queue().at(next));
+    }
+    m_preloaded = next;
+}
+
+void GaplessPlayer::swapDecks(bool play)
+{
+    QMediaPlayer *previous = active();
+    m_active ^= 1;
+    m_preloaded = -1;
+
+    // Start the prepared deck before stopping the old one, so the only
+    // gap left is the output's own start-up
+    if (play) {
+        active()->play();
+    }
+    previous->stop();
+    qCDebug(lcPlayback) << "Switched to preloaded" << active()->source();
+
+    // The new deck loaded while it was on standby, so its duration and
+    // tags were never forwarded
+    emit durationChanged(active()->duration());
+    emit positionChanged(active()->position());
+    emit metaDataChanged();
+    updateState();
+}
@@ -0,0 +1,55 @@
+#ifndef GAPLESSPLAYER_H
+#define GAPLESSPLAYER_H
+
+#include <QAudioOutput>
+#include "playbackbackend.h"
+
+// Plays the queue through two media players. While one deck plays, the
+// other already has the next queue entry opened and prerolled, so a
+// track boundary (or a skip to the next entry) only has to start a
+// decoder that is ready, instead of opening and probing a new file.
+// Signals are only forwarded from the deck that is currently playing.
+class GaplessPlayer : public PlaybackBackend
+{
+    Q_OBJECT
+
+public:
+    explicit GaplessPlayer(QObject *parent = nullptr);
+
+    QMediaPlayer::PlaybackState playbackState() const override;
+    qint64 position() const override;
+    qint64 duration() const override;
+    QMediaMetaData metaData() const override;
+    float volume() const override;
+
+public slots:
+    void play() override;
+    void pause() override;
+    void stop() override;
+    void setPosition(qint64 position) override;
+    void setVolume(float volume) override;
+    void setReplayGainMode(ReplayGainMode mode) override;
+
+protected:
+    void load(int index, bool play) override;
+
+private:
+    QMediaPlayer *active() const;
+    QMediaPlayer *standby() const;
+    void setupDeck(int deck);
+    void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void onPlaybackStateChanged(QMediaPlayer::PlaybackState state);
+    void updateState();
+    void preload();
+    void swapDecks(bool play);
+    void applyGain();
+
+    QMediaPlayer *m_players[2];
+    QAudioOutput *m_outputs[2];
+    int m_active;           // index into m_players
+    int m_preloaded;        // queue entry opened on the standby deck, -1 for none
+    float m_volume;
+    QMediaPlayer::PlaybackState m_state;
+};
+
+#endif // GAPLESSPLAYER_H
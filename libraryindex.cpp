@@ -0,0 +1,94 @@
+#include "libraryindex.h"
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include "logging.h"
+#include "trackstore.h"
+
+namespace {
+    constexpr quint32 INDEX_MAGIC = 0x4d555345; // "MUSE"
+    constexpr quint32 INDEX_VERSION = 7;
+    // A TrackInfo with every string empty; floats are written as doubles
+    constexpr qint64 MIN_ENTRY_SIZE = 97;
+}
+
+LibraryIndex::LibraryIndex()
+    : m_dirty(false)
+{
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    m_fileName = dataDir + "/library.index";
+}
+
+bool LibraryIndex::load(QList<TrackInfo> *tracks) const
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+        qCWarning(lcLibrary) << "Ignoring library index with unknown format:" << m_fileName;
+        return false;
+    }
+
+    quint32 count = 0;
+    in >> count;
+    // The count is only trusted as far as the file could hold it
+    if (in.status() != QDataStream::Ok || count > (file.size() - file.pos()) / MIN_ENTRY_SIZE) {
+        qCWarning(lcLibrary) << "Library index is truncated, discarding:" << m_fileName;
+        return false;
+    }
+
+    QList<TrackInfo> entries;
+    entries.reserve(count);
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        TrackInfo info;
+        in >> info;
+        entries.append(info);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qCWarning(lcLibrary) << "Library index is truncated, discarding:" << m_fileName;
+        return false;
+    }
+
+    *tracks = std::move(entries);
+    return true;
+}
+
+bool LibraryIndex::save(const TrackStore &store)
+{
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcLibrary) << "Could not write library index:" << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << INDEX_MAGIC << INDEX_VERSION << quint32(store.trackCount());
+    for (int id = 0; id < store.idLimit(); ++id) {
+        if (store.contains(id)) {
+            out << store.track(id);
+        }
+    }
+
+    if (!file.commit()) {
+        qCWarning(lcLibrary) << "Could not write library index:" << file.errorString();
+        return false;
+    }
+
+    m_dirty = false;
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef LIBRARYINDEX_H
+#define LIBRARYINDEX_H
+
+#include <QList>
+#include <QString>
+#include "trackinfo.h"
+
+class TrackStore;
+
+// On-disk copy of the track store, so the library shows up before the
+// first scan and unchanged files (same size + mtime) skip TagLib
+class LibraryIndex
+{
+public:
+    LibraryIndex();
+
+    bool load(QList<TrackInfo> *tracks) const;
+    bool save(const TrackStore &store);
+
+    QString fileName() const { return m_fileName; }
+    bool isDirty() const { return m_dirty; }
+    void setDirty() { m_dirty = true; }
+
+private:
+    QString m_fileName;
+    bool m_dirty;
+};
+
+#endif // LIBRARYINDEX_H
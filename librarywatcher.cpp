@@ -0,0 +1,226 @@
+#include "librarywatcher.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include "logging.h"
+
+namespace {
+    constexpr int DEBOUNCE_INTERVAL_MS = 500;
+    constexpr int POLL_INTERVAL_MS = 30000;
+    constexpr qint64 MTIME_UNKNOWN = -2;
+    constexpr qint64 MTIME_MISSING = -1;
+
+    bool isSameOrBelow(const QString &path, const QString &dir)
+    {
+        return path == dir || (path.startsWith(dir) && path.at(dir.size()) == QLatin1Char('/'));
+    }
+}
+
+LibraryWatcher::LibraryWatcher(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_pollRunning(false)
+    , m_watchLimitReached(false)
+{
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &LibraryWatcher::onDirectoryChanged);
+
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(DEBOUNCE_INTERVAL_MS);
+    connect(&m_debounceTimer, &QTimer::timeout, this, &LibraryWatcher::emitChanged);
+
+    m_pollTimer.setInterval(POLL_INTERVAL_MS);
+    connect(&m_pollTimer, &QTimer::timeout, this, &LibraryWatcher::poll);
+
+    m_pollPool.setMaxThreadCount(1);
+}
+
+LibraryWatcher::~LibraryWatcher()
+{
+    m_pollPool.waitForDone();
+}
+
+void LibraryWatcher::addDirectories(const QStringList &dirs)
+{
+    QStringList newDirs;
+    for (const QString &dir : dirs) {
+        if (!contains(dir)) {
+            newDirs.append(dir);
+        }
+    }
+    if (newDirs.isEmpty()) {
+        return;
+    }
+
+    QStringList failed;
+    if (m_watchLimitReached) {
+        failed = newDirs;
+    } else {
+        failed = m_watcher->addPaths(newDirs);
+        const QSet<QString> failedSet(failed.cbegin(), failed.cend());
+        for (const QString &dir : std::as_const(newDirs)) {
+            if (!failedSet.contains(dir)) {
+                m_watched.insert(dir);
+            }
+        }
+    }
+
+    if (failed.isEmpty()) {
+        return;
+    }
+
+    if (!m_watchLimitReached) {
+        // Usually fs.inotify.max_user_watches; keep going by polling
+        m_watchLimitReached = true;
+        qCWarning(lcLibrary) << "File system watch limit reached after" << m_watched.size()
+                             << "directories, polling the rest every" << POLL_INTERVAL_MS / 1000 << "s";
+    }
+
+    // Record baseline mtimes now rather than at the next poll, which
+    // could be most of an interval away
+    QHash<QString, qint64> baseline;
+    for (const QString &dir : std::as_const(failed)) {
+        m_polled.insert(dir, MTIME_UNKNOWN);
+        baseline.insert(dir, MTIME_UNKNOWN);
+    }
+    stat(baseline, false);
+    if (!m_pollTimer.isActive()) {
+        m_pollTimer.start();
+    }
+}
+
+void LibraryWatcher::removeDirectories(const QString &dir)
+{
+    QStringList unwatch;
+    for (const QString &path : std::as_const(m_watched)) {
+        if (isSameOrBelow(path, dir)) {
+            unwatch.append(path);
+        }
+    }
+    for (const QString &path : std::as_const(unwatch)) {
+        m_watched.remove(path);
+    }
+    if (!unwatch.isEmpty()) {
+        m_watcher->removePaths(unwatch);
+    }
+
+    for (auto it = m_polled.begin(); it != m_polled.end();) {
+        if (isSameOrBelow(it.key(), dir)) {
+            it = m_polled.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Freed watches go to the polled directories first
+    if (!unwatch.isEmpty()) {
+        m_watchLimitReached = false;
+        watchPolled();
+    }
+    if (m_polled.isEmpty()) {
+        m_pollTimer.stop();
+    }
+}
+
+bool LibraryWatcher::contains(const QString &dir) const
+{
+    return m_watched.contains(dir) || m_polled.contains(dir);
+}
+
+void LibraryWatcher::onDirectoryChanged(const QString &dir)
+{
+    m_dirty.insert(dir);
+    m_debounceTimer.start();
+}
+
+void LibraryWatcher::emitChanged()
+{
+    if (m_dirty.isEmpty()) {
+        return;
+    }
+
+    const QStringList dirs(m_dirty.cbegin(), m_dirty.cend());
+    m_dirty.clear();
+    emit directoriesChanged(dirs);
+}
+
+void LibraryWatcher::poll()
+{
+    if (m_pollRunning || m_polled.isEmpty()) {
+        return;
+    }
+    m_pollRunning = true;
+    stat(m_polled, true);
+}
+
+// Stat on a worker; a slow network mount must not block the GUI thread.
+// The pool runs one job at a time, so results come back in order
+void LibraryWatcher::stat(const QHash<QString, qint64> &dirs, bool fullPoll)
+{
+    if (dirs.isEmpty()) {
+        return;
+    }
+
+    m_pollPool.start([this, dirs, fullPoll]() {
+        QStringList changed;
+        QHash<QString, qint64> modified;
+        for (auto it = dirs.cbegin(); it != dirs.cend(); ++it) {
+            QFileInfo fileInfo(it.key());
+            const qint64 mtime = fileInfo.exists()
+                ? fileInfo.lastModified().toMSecsSinceEpoch() : MTIME_MISSING;
+            if (mtime != it.value()) {
+                modified.insert(it.key(), mtime);
+                if (it.value() != MTIME_UNKNOWN) {
+                    changed.append(it.key());
+                }
+            }
+        }
+
+        QMetaObject::invokeMethod(this, [this, changed, modified, fullPoll]() {
+            onPollFinished(changed, modified, fullPoll);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void LibraryWatcher::onPollFinished(const QStringList &changed, const QHash<QString, qint64> &modified,
+                                    bool fullPoll)
+{
+    if (fullPoll) {
+        m_pollRunning = false;
+    }
+
+    for (auto it = modified.cbegin(); it != modified.cend(); ++it) {
+        // Skip directories removed while the poll was running
+        auto polled = m_polled.find(it.key());
+        if (polled != m_polled.end()) {
+            polled.value() = it.value();
+        }
+    }
+
+    // Directories promoted to a watch since are still reported
+    for (const QString &dir : changed) {
+        if (contains(dir)) {
+            onDirectoryChanged(dir);
+        }
+    }
+}
+
+void LibraryWatcher::watchPolled()
+{
+    if (m_polled.isEmpty()) {
+        return;
+    }
+
+    const QStringList polled = m_polled.keys();
+    const QStringList failed = m_watcher->addPaths(polled);
+    const QSet<QString> failedSet(failed.cbegin(), failed.cend());
+    QHash<QString, qint64> promoted;
+    for (const QString &dir : polled) {
+        if (!failedSet.contains(dir)) {
+            m_watched.insert(dir);
+            promoted.insert(dir, m_polled.take(dir));
+        }
+    }
+    m_watchLimitReached = !failed.isEmpty();
+
+    // One last look for changes since their last poll
+    stat(promoted, false);
+}
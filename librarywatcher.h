@@ -0,0 +1,56 @@
+#ifndef LIBRARYWATCHER_H
+#define LIBRARYWATCHER_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QThreadPool>
+
+// Reports library directories whose entries changed. Uses QFileSystemWatcher
+// while the kernel has watches to spare and falls back to polling directory
+// mtimes for the rest, until removed directories free watches for them.
+class LibraryWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LibraryWatcher(QObject *parent = nullptr);
+    ~LibraryWatcher();
+
+    void addDirectories(const QStringList &dirs);
+    // Stops watching dir and everything below it
+    void removeDirectories(const QString &dir);
+    bool contains(const QString &dir) const;
+
+    int watchedCount() const { return m_watched.size(); }
+    int polledCount() const { return m_polled.size(); }
+
+signals:
+    // Emitted once per burst of changes, after the debounce interval
+    void directoriesChanged(const QStringList &dirs);
+
+private slots:
+    void onDirectoryChanged(const QString &dir);
+    void emitChanged();
+    void poll();
+
+private:
+    void stat(const QHash<QString, qint64> &dirs, bool fullPoll);
+    void onPollFinished(const QStringList &changed, const QHash<QString, qint64> &modified, bool fullPoll);
+    void watchPolled();
+
+    QFileSystemWatcher *m_watcher;
+    QSet<QString> m_watched;
+    QHash<QString, qint64> m_polled;    // dir -> last seen mtime
+    QSet<QString> m_dirty;
+    QTimer m_debounceTimer;
+    QTimer m_pollTimer;
+    QThreadPool m_pollPool;
+    bool m_pollRunning;
+    bool m_watchLimitReached;
+};
+
+#endif // LIBRARYWATCHER_H
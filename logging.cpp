@@ -0,0 +1,10 @@
+#include "logging.h"
+
+// Debug output is opt-in for every category, since some of it comes
+// per keystroke or per frame
+Q_LOGGING_CATEGORY(lcLibrary, "muse.library", QtInfoMsg)
+// Per-file messages; far too chatty to be on by default
+Q_LOGGING_CATEGORY(lcScan, "muse.library.scan", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcPlayback, "muse.playback", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcUi, "muse.ui", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcTrace, "muse.trace", QtInfoMsg)
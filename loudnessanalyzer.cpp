@@ -0,0 +1,197 @@
+#include "loudnessanalyzer.h"
+#include "loudnessmeter.h"
+#include "filedecoder.h"
+#include "waveformstore.h"
+#include "seektablestore.h"
+#include "logging.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <memory>
+
+LoudnessAnalyzer::LoudnessAnalyzer(QObject *parent)
+    : QObject(parent)
+    , m_activeWorkers(0)
+    , m_generation(0)
+{
+    // Decoding is CPU bound; stay out of the way of everything else
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+    m_pool.setThreadPriority(QThread::IdlePriority);
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void LoudnessAnalyzer::enqueue(const QList<TrackInfo> &album)
+{
+    if (album.isEmpty()) {
+        return;
+    }
+
+    bool startWorker = false;
+    quint64 generation;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const TrackInfo &info : album) {
+            if (m_queued.contains(info.filePath)) {
+                return;
+            }
+        }
+        for (const TrackInfo &info : album) {
+            m_queued.insert(info.filePath);
+        }
+        m_queue.append(album);
+        startWorker = m_activeWorkers < m_pool.maxThreadCount();
+        if (startWorker) {
+            ++m_activeWorkers;
+        }
+        generation = m_generation;
+    }
+
+    if (startWorker) {
+        m_pool.start([this, generation]() {
+            work(generation);
+        });
+    }
+}
+
+void LoudnessAnalyzer::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_generation;
+    m_queue.clear();
+    m_queued.clear();
+}
+
+bool LoudnessAnalyzer::isBusy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_queue.isEmpty() || m_activeWorkers > 0;
+}
+
+bool LoudnessAnalyzer::isCancelled(quint64 generation) const
+{
+    QMutexLocker locker(&m_mutex);
+    return generation != m_generation;
+}
+
+void LoudnessAnalyzer::work(quint64 generation)
+{
+    forever {
+        QList<TrackInfo> album;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.isEmpty()) {
+                --m_activeWorkers;
+                return;
+            }
+            // A worker that outlived cancel() still counts as active, so
+            // it carries on with the queue that replaced its own
+            generation = m_generation;
+            album = m_queue.takeFirst();
+        }
+
+        QVector<double> albumBlocks;
+        float albumPeak = 0;
+        bool cancelled = false;
+        for (TrackInfo &info : album) {
+            QVector<double> blocks;
+            if (!measure(info, generation, &info.loudness.track, &blocks)) {
+                if (isCancelled(generation)) {
+                    cancelled = true;
+                    break;
+                }
+                // Left unmeasured, which tells the library it failed; the
+                // album is measured over the rest
+                info.loudness.track = Loudness();
+                continue;
+            }
+            albumBlocks.append(blocks);
+            albumPeak = qMax(albumPeak, info.loudness.track.truePeak);
+        }
+        if (cancelled) {
+            continue;   // the generation check above ends the worker
+        }
+
+        Loudness albumLoudness;
+        albumLoudness.integrated = float(LoudnessMeter::integrated(albumBlocks));
+        albumLoudness.truePeak = albumPeak;
+        for (TrackInfo &info : album) {
+            if (info.loudness.track.isValid()) {
+                info.loudness.album = albumLoudness;
+            }
+        }
+        qCDebug(lcLibrary) << "Measured" << album.size() << "tracks at" << albumLoudness.integrated << "LUFS";
+
+        {
+            QMutexLocker locker(&m_mutex);
+            if (generation != m_generation) {
+                continue;
+            }
+            for (const TrackInfo &info : std::as_const(album)) {
+                m_queued.remove(info.filePath);
+            }
+        }
+        emit albumMeasured(album);
+    }
+}
+
+bool LoudnessAnalyzer::measure(const TrackInfo &info, quint64 generation, Loudness *loudness, QVector<double> *blocks)
+{
+    // Surround sources are measured as their stereo downmix
+    QAudioFormat format;
+    format.setSampleFormat(QAudioFormat::Float);
+    format.setSampleRate(48000);
+    format.setChannelCount(2);
+
+    // The audio is decoded anyway, so the seek bar's waveform comes along
+    const QString key = WaveformStore::key(info.filePath, info.size, info.modified);
+    const bool wantWaveform = !WaveformStore::contains(key);
+
+    std::unique_ptr<LoudnessMeter> meter;
+    std::unique_ptr<WaveformBuilder> waveform;
+    QString errorString;
+    const bool ok = FileDecoder::decode(info.filePath, format, [&](const QAudioBuffer &buffer) {
+        const QAudioFormat bufferFormat = buffer.format();
+        // The K-weighting filters and the true-peak oversampler are set up
+        // for the first buffer's rate and channels
+        if (bufferFormat.sampleFormat() != QAudioFormat::Float
+                || (meter && (bufferFormat.channelCount() != format.channelCount()
+                              || bufferFormat.sampleRate() != format.sampleRate()))) {
+            qCWarning(lcLibrary) << "Unexpected decoder format while measuring" << info.filePath;
+            return false;
+        }
+        if (!meter) {
+            format = bufferFormat;
+            meter = std::make_unique<LoudnessMeter>(format.sampleRate(), format.channelCount());
+            if (wantWaveform) {
+                waveform = std::make_unique<WaveformBuilder>(format.channelCount());
+            }
+        }
+        meter->process(buffer.constData<float>(), buffer.frameCount());
+        if (waveform) {
+            waveform->add(buffer.constData<float>(), buffer.frameCount());
+        }
+        return !isCancelled(generation);
+    }, &errorString);
+
+    if (!ok || !meter) {
+        if (!errorString.isEmpty()) {
+            qCWarning(lcLibrary) << "Could not measure" << info.filePath << errorString;
+        }
+        return false;
+    }
+    loudness->integrated = float(meter->integrated());
+    loudness->truePeak = float(meter->truePeak());
+    *blocks = meter->blocks();
+    if (waveform) {
+        WaveformStore::store(key, waveform->finish());
+    }
+    // Cheap next to the decode: one pass over the frame headers
+    if (!SeekTableStore::contains(key)) {
+        SeekTableStore::store(key, SeekTable::build(info.filePath));
+    }
+    return true;
+}
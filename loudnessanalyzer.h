@@ -0,0 +1,51 @@
+#ifndef LOUDNESSANALYZER_H
+#define LOUDNESSANALYZER_H
+
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+#include "trackinfo.h"
+
+// Measures loudness for ReplayGain in the background. Each job is an
+// album, or a track on its own, decoded and metered on one thread of an
+// idle-priority pool with a thread per core. The album's loudness gates
+// the blocks of all its tracks together, as if they were one recording.
+// Results are handed back to the GUI thread an album at a time. Tracks
+// without a cached waveform get one from the same decode, and MP3 and
+// FLAC files a seek table.
+class LoudnessAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoudnessAnalyzer(QObject *parent = nullptr);
+    ~LoudnessAnalyzer();
+
+    // The tracks come back from albumMeasured() with their loudness set,
+    // or left unmeasured if they could not be decoded; albums with a track
+    // already queued are skipped
+    void enqueue(const QList<TrackInfo> &album);
+    void cancel();
+    bool isBusy() const;
+
+signals:
+    void albumMeasured(const QList<TrackInfo> &tracks);
+
+private:
+    void work(quint64 generation);
+    bool measure(const TrackInfo &info, quint64 generation, Loudness *loudness, QVector<double> *blocks);
+    bool isCancelled(quint64 generation) const;
+
+    QThreadPool m_pool;
+
+    mutable QMutex m_mutex;
+    QList<QList<TrackInfo>> m_queue;
+    QSet<QString> m_queued;     // files queued or being measured
+    int m_activeWorkers;
+    quint64 m_generation;
+};
+
+#endif // LOUDNESSANALYZER_H
@@ -0,0 +1,335 @@
+#include "loudnessmeter.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOUDNESS_SSE2
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define LOUDNESS_NEON
+#endif
+
+#if defined(LOUDNESS_SSE2) || defined(LOUDNESS_NEON)
+#define LOUDNESS_SIMD
+#endif
+
+namespace {
+#if defined(LOUDNESS_SSE2)
+    // Two channels of the filters, in double precision
+    using Double2 = __m128d;
+    inline Double2 load(const double *p) { return _mm_loadu_pd(p); }
+    inline void store(double *p, Double2 v) { _mm_storeu_pd(p, v); }
+    inline Double2 splat(double x) { return _mm_set1_pd(x); }
+    inline Double2 add(Double2 a, Double2 b) { return _mm_add_pd(a, b); }
+    inline Double2 sub(Double2 a, Double2 b) { return _mm_sub_pd(a, b); }
+    inline Double2 mul(Double2 a, Double2 b) { return _mm_mul_pd(a, b); }
+    inline Double2 loadPair(const float *p)
+    {
+        return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+    }
+
+    // Four samples of the oversampling filter
+    using Float4 = __m128;
+    inline Float4 load(const float *p) { return _mm_loadu_ps(p); }
+    inline void store(float *p, Float4 v) { _mm_storeu_ps(p, v); }
+    inline Float4 splat(float x) { return _mm_set1_ps(x); }
+    inline Float4 add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+    inline Float4 mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+    inline Float4 max(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+    inline Float4 abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+#elif defined(LOUDNESS_NEON)
+    using Double2 = float64x2_t;
+    inline Double2 load(const double *p) { return vld1q_f64(p); }
+    inline void store(double *p, Double2 v) { vst1q_f64(p, v); }
+    inline Double2 splat(double x) { return vdupq_n_f64(x); }
+    inline Double2 add(Double2 a, Double2 b) { return vaddq_f64(a, b); }
+    inline Double2 sub(Double2 a, Double2 b) { return vsubq_f64(a, b); }
+    inline Double2 mul(Double2 a, Double2 b) { return vmulq_f64(a, b); }
+    inline Double2 loadPair(const float *p) { return vcvt_f64_f32(vld1_f32(p)); }
+
+    using Float4 = float32x4_t;
+    inline Float4 load(const float *p) { return vld1q_f32(p); }
+    inline void store(float *p, Float4 v) { vst1q_f32(p, v); }
+    inline Float4 splat(float x) { return vdupq_n_f32(x); }
+    inline Float4 add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+    inline Float4 mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+    inline Float4 max(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+    inline Float4 abs(Float4 a) { return vabsq_f32(a); }
+#endif
+
+#ifdef LOUDNESS_SIMD
+    constexpr qsizetype LANES = 4;
+#endif
+
+    constexpr double PI = 3.14159265358979323846;
+    constexpr qsizetype CHUNK_FRAMES = 4096;
+    constexpr int TAPS = 12;                // per oversampling phase
+    constexpr double ABSOLUTE_GATE = -70.0; // LUFS
+    constexpr double RELATIVE_GATE = -10.0; // LU below the absolutely gated loudness
+    constexpr double DENORMAL = 1e-20;      // filter state below this is flushed
+
+    inline double powerOf(double lufs)
+    {
+        return std::pow(10.0, (lufs + 0.691) / 10.0);
+    }
+
+    inline double loudnessOf(double power)
+    {
+        return -0.691 + 10.0 * std::log10(power);
+    }
+}
+
+LoudnessMeter::LoudnessMeter(int sampleRate, int channels)
+    : m_channels(channels)
+    , m_state(new double[4 * channels]())
+    , m_weights(new double[channels])
+    , m_stepFrames(qMax<qsizetype>(qRound64(sampleRate * 0.1), 1))
+    , m_stepFill(0)
+    , m_stepSum(0)
+    , m_steps{}
+    , m_stepCount(0)
+    , m_phases(sampleRate < 96000 ? 4 : sampleRate < 192000 ? 2 : 1)
+    , m_taps(new float[m_phases * TAPS])
+    , m_history(new float[(TAPS - 1) * channels]())
+    , m_line(new float[TAPS - 1 + CHUNK_FRAMES])
+    , m_peak(0)
+{
+    // BS.1770 specifies the filters at 48 kHz; these are the analog
+    // prototypes behind them, so other rates get the same response
+    double f0 = 1681.974450955533;
+    double q = 0.7071752369554196;
+    double k = std::tan(PI * f0 / sampleRate);
+    const double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m_shelf = { (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(PI * f0 / sampleRate);
+    a0 = 1.0 + k / q + k * k;
+    m_highPass = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+
+    // Surround channels count more, the LFE not at all (5.0 and 5.1 in
+    // the usual L R C [LFE] Ls Rs order)
+    for (int c = 0; c < channels; ++c) {
+        m_weights[c] = 1.0;
+    }
+    if (channels == 5) {
+        m_weights[3] = m_weights[4] = 1.41;
+    } else if (channels == 6) {
+        m_weights[3] = 0.0;
+        m_weights[4] = m_weights[5] = 1.41;
+    }
+
+    // Windowed sinc at the original Nyquist frequency, split into one set
+    // of taps per output phase, each normalized to unity gain
+    const int length = m_phases * TAPS;
+    for (int p = 0; p < m_phases; ++p) {
+        double sum = 0;
+        for (int i = 0; i < TAPS; ++i) {
+            const int n = p + m_phases * i;
+            const double t = (n - (length - 1) / 2.0) / m_phases;
+            const double sinc = t == 0.0 ? 1.0 : std::sin(PI * t) / (PI * t);
+            const double window = 0.5 - 0.5 * std::cos(2.0 * PI * (n + 0.5) / length);
+            m_taps[p * TAPS + i] = float(sinc * window);
+            sum += sinc * window;
+        }
+        for (int i = 0; i < TAPS; ++i) {
+            m_taps[p * TAPS + i] = float(m_taps[p * TAPS + i] / sum);
+        }
+    }
+}
+
+LoudnessMeter::~LoudnessMeter() = default;
+
+void LoudnessMeter::process(const float *samples, qsizetype frames)
+{
+    while (frames > 0) {
+        // Never run past the end of a 100 ms step
+        const qsizetype count = std::min({ frames, CHUNK_FRAMES, m_stepFrames - m_stepFill });
+        m_stepSum += filter(samples, count);
+        measurePeaks(samples, count);
+        m_stepFill += count;
+
+        if (m_stepFill == m_stepFrames) {
+            // A gating block is the last four steps
+            m_steps[m_stepCount & 3] = m_stepSum;
+            ++m_stepCount;
+            if (m_stepCount >= 4) {
+                m_blocks.append((m_steps[0] + m_steps[1] + m_steps[2] + m_steps[3]) / double(4 * m_stepFrames));
+            }
+            m_stepSum = 0;
+            m_stepFill = 0;
+        }
+
+        samples += count * m_channels;
+        frames -= count;
+    }
+}
+
+double LoudnessMeter::integrated() const
+{
+    return integrated(m_blocks);
+}
+
+double LoudnessMeter::truePeak() const
+{
+    return m_peak;
+}
+
+const QVector<double> &LoudnessMeter::blocks() const
+{
+    return m_blocks;
+}
+
+double LoudnessMeter::integrated(const QVector<double> &blocks)
+{
+    const double absoluteGate = powerOf(ABSOLUTE_GATE);
+    double sum = 0;
+    qsizetype count = 0;
+    for (double power : blocks) {
+        if (power > absoluteGate) {
+            sum += power;
+            ++count;
+        }
+    }
+    if (count == 0) {
+        return -HUGE_VAL;
+    }
+
+    const double gate = std::max(absoluteGate, sum / double(count) * std::pow(10.0, RELATIVE_GATE / 10.0));
+    sum = 0;
+    count = 0;
+    for (double power : blocks) {
+        if (power > gate) {
+            sum += power;
+            ++count;
+        }
+    }
+    return loudnessOf(sum / double(count));
+}
+
+double LoudnessMeter::filter(const float *samples, qsizetype frames)
+{
+    const Biquad &s = m_shelf;
+    const Biquad &h = m_highPass;
+    double sum = 0;
+    int c = 0;
+
+#ifdef LOUDNESS_SIMD
+    const Double2 sb0 = splat(s.b0), sb1 = splat(s.b1), sb2 = splat(s.b2), sa1 = splat(s.a1), sa2 = splat(s.a2);
+    const Double2 hb0 = splat(h.b0), hb1 = splat(h.b1), hb2 = splat(h.b2), ha1 = splat(h.a1), ha2 = splat(h.a2);
+    for (; c + 2 <= m_channels; c += 2) {
+        double *state = m_state.get() + 4 * c;
+        Double2 z1 = load(state);
+        Double2 z2 = load(state + 2);
+        Double2 w1 = load(state + 4);
+        Double2 w2 = load(state + 6);
+        Double2 power = splat(0.0);
+
+        // Transposed direct form II, both stages back to back
+        const float *x = samples + c;
+        for (qsizetype i = 0; i < frames; ++i, x += m_channels) {
+            const Double2 in = loadPair(x);
+            const Double2 y = add(mul(sb0, in), z1);
+            z1 = sub(add(mul(sb1, in), z2), mul(sa1, y));
+            z2 = sub(mul(sb2, in), mul(sa2, y));
+            const Double2 out = add(mul(hb0, y), w1);
+            w1 = sub(add(mul(hb1, y), w2), mul(ha1, out));
+            w2 = sub(mul(hb2, y), mul(ha2, out));
+            power = add(power, mul(out, out));
+        }
+
+        store(state, z1);
+        store(state + 2, z2);
+        store(state + 4, w1);
+        store(state + 6, w2);
+        double lanes[2];
+        store(lanes, mul(power, load(m_weights.get() + c)));
+        sum += lanes[0] + lanes[1];
+    }
+#endif
+
+    for (; c < m_channels; ++c) {
+        double *state = m_state.get() + 4 * c;
+        double z1 = state[0], z2 = state[1], w1 = state[2], w2 = state[3];
+        double power = 0;
+        const float *x = samples + c;
+        for (qsizetype i = 0; i < frames; ++i, x += m_channels) {
+            const double in = *x;
+            const double y = s.b0 * in + z1;
+            z1 = s.b1 * in + z2 - s.a1 * y;
+            z2 = s.b2 * in - s.a2 * y;
+            const double out = h.b0 * y + w1;
+            w1 = h.b1 * y + w2 - h.a1 * out;
+            w2 = h.b2 * y - h.a2 * out;
+            power += out * out;
+        }
+        state[0] = z1;
+        state[1] = z2;
+        state[2] = w1;
+        state[3] = w2;
+        sum += power * m_weights[c];
+    }
+
+    // Decaying state would turn denormal over a long silence
+    for (int i = 0; i < 4 * m_channels; ++i) {
+        if (std::fabs(m_state[i]) < DENORMAL) {
+            m_state[i] = 0.0;
+        }
+    }
+    return sum;
+}
+
+void LoudnessMeter::measurePeaks(const float *samples, qsizetype frames)
+{
+    float peak = m_peak;
+    for (int c = 0; c < m_channels; ++c) {
+        if (m_phases == 1) {
+            for (qsizetype i = 0; i < frames; ++i) {
+                peak = std::max(peak, std::fabs(samples[i * m_channels + c]));
+            }
+            continue;
+        }
+
+        // The channel's last samples, then this chunk of it
+        float *history = m_history.get() + c * (TAPS - 1);
+        float *line = m_line.get();
+        std::copy(history, history + TAPS - 1, line);
+        for (qsizetype i = 0; i < frames; ++i) {
+            line[TAPS - 1 + i] = samples[i * m_channels + c];
+        }
+        const float *x = line + TAPS - 1;   // x[i - k] is k samples back
+
+        for (int p = 0; p < m_phases; ++p) {
+            const float *taps = m_taps.get() + p * TAPS;
+            qsizetype i = 0;
+#ifdef LOUDNESS_SIMD
+            Float4 peaks = splat(peak);
+            for (; i + LANES <= frames; i += LANES) {
+                Float4 out = mul(splat(taps[0]), load(x + i));
+                for (int k = 1; k < TAPS; ++k) {
+                    out = add(out, mul(splat(taps[k]), load(x + i - k)));
+                }
+                peaks = max(peaks, abs(out));
+            }
+            float lanes[LANES];
+            store(lanes, peaks);
+            peak = *std::max_element(lanes, lanes + LANES);
+#endif
+            for (; i < frames; ++i) {
+                float out = 0;
+                for (int k = 0; k < TAPS; ++k) {
+                    out += taps[k] * x[i - k];
+                }
+                peak = std::max(peak, std::fabs(out));
+            }
+        }
+
+        std::copy(line + frames, line + frames + TAPS - 1, history);
+    }
+    m_peak = peak;
+}
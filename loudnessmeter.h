@@ -0,0 +1,62 @@
+#ifndef LOUDNESSMETER_H
+#define LOUDNESSMETER_H
+
+#include <QVector>
+#include <memory>
+
+// EBU R128 / ITU-R BS.1770 measurement of interleaved float audio.
+// Samples go through the K-weighting filters, two channels at a time in
+// SSE2 or NEON double lanes, and their power is summed over 400 ms gating
+// blocks that overlap by 75%. The blocks are kept, so several tracks can
+// be gated together for an album. The true peak is taken from a 4x (2x
+// above 96 kHz) polyphase oversampling of each channel.
+class LoudnessMeter
+{
+public:
+    LoudnessMeter(int sampleRate, int channels);
+    ~LoudnessMeter();
+
+    void process(const float *samples, qsizetype frames);
+
+    // Integrated loudness in LUFS; -infinity if nothing is above the
+    // absolute gate
+    double integrated() const;
+    // Largest absolute sample value of the oversampled signal
+    double truePeak() const;
+    // Mean square power of each gating block, K-weighted
+    const QVector<double> &blocks() const;
+
+    // Integrated loudness over the blocks of one or more meters
+    static double integrated(const QVector<double> &blocks);
+
+private:
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    double filter(const float *samples, qsizetype frames);
+    void measurePeaks(const float *samples, qsizetype frames);
+
+    const int m_channels;
+    Biquad m_shelf;             // stage 1, high shelf
+    Biquad m_highPass;          // stage 2, RLB high pass
+    std::unique_ptr<double[]> m_state;      // 4 per channel, lanes interleaved in pairs
+    std::unique_ptr<double[]> m_weights;    // per channel
+
+    // Gating blocks are built from 100 ms steps
+    qsizetype m_stepFrames;
+    qsizetype m_stepFill;
+    double m_stepSum;
+    double m_steps[4];
+    int m_stepCount;
+    QVector<double> m_blocks;
+
+    int m_phases;
+    std::unique_ptr<float[]> m_taps;        // per phase, newest sample first
+    std::unique_ptr<float[]> m_history;     // last taps per channel
+    std::unique_ptr<float[]> m_line;        // one channel's history and chunk
+    float m_peak;
+};
+
+#endif // LOUDNESSMETER_H
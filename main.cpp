@@ -1,12 +1,21 @@
 #include <QApplication>
 #include "mainwindow.h"
+#include "playbackcore.h"
+#include "startupclock.h"
+#include "trace.h"
 
 int main(int argc, char *argv[])
 {
+    StartupClock::start();
+    Trace::start();
     QApplication app(argc, argv);
     
-    MainWindow window;
+    // One player for every front end
+    PlaybackCore core;
+    MainWindow window(&core);
     window.show();
     
-    return app.exec();
+    const int result = app.exec();
+    Trace::finish();
+    return result;
 }
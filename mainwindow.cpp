@@ -10,56 +10,63 @@
 #include <QDebug>
 #include <QResizeEvent>
 #include <QPainter>
-#include <QPainterPath>
 #include <QStyleFactory>
 #include <QStyleOption>
 #include <QStylePainter>
 #include <QGraphicsBlurEffect>
-#include <QMediaMetaData>
 #include <QStackedWidget>
 #include <QProcess>
-#include <taglib/taglib.h>
-#include <taglib/fileref.h>
-#include <taglib/tag.h>
-#include <taglib/tfile.h>
-#include <taglib/apefile.h>
-#include <taglib/asffile.h>
-#include <taglib/flacfile.h>
-#include <taglib/mp4file.h>
-#include <taglib/mpcfile.h>
-#include <taglib/mpegfile.h>
-#include <taglib/oggfile.h>
-#include <taglib/opusfile.h>
-#include <taglib/wavfile.h>
-#include <taglib/wavpackfile.h>
-#include <taglib/attachedpictureframe.h>
-#include <taglib/id3v2tag.h>
-#include <taglib/id3v2frame.h>
-#include <taglib/id3v2header.h>
-#include <taglib/flacpicture.h>
-#include <taglib/mp4coverart.h>
-
-MainWindow::MainWindow(QWidget *parent)
+#include <QTimer>
+#include <QElapsedTimer>
+#include "logging.h"
+#include "startupclock.h"
+#include "trace.h"
+
+namespace {
+    // Quiet time after the last resize event before the art is redone
+    // smoothly; a drag delivers them much more often than this
+    constexpr int ART_RESIZE_DELAY = 150;  // msecs
+    // Searches slower than this are logged as warnings
+    constexpr qint64 SEARCH_BUDGET = 5000;  // usecs
+}
+
+MainWindow::MainWindow(PlaybackCore *core, QWidget *parent)
     : QMainWindow(parent)
 {
     // Use system theme
     qApp->setStyle(QApplication::style()->objectName());
     
-    // Initialize media player and audio output first
-    mediaPlayer = new QMediaPlayer(this);
-    audioOutput = new QAudioOutput(this);
-    mediaPlayer->setAudioOutput(audioOutput);
+    // The player is the app's shared one, created by finishStartup()
+    playbackCore = core;
+    mediaPlayer = nullptr;
+    fullscreenPlayer = nullptr;
+    searching = false;
     
     // Initialize music library
     musicLibrary = new MusicLibrary(this);
-    connect(musicLibrary, &MusicLibrary::audioFilesChanged, this, &MainWindow::onAudioFilesChanged);
+    playbackCore->setLibrary(musicLibrary);
+    waveformGenerator = new WaveformGenerator(this);
+    artLoader = new ArtLoader(this);
+    frameScheduler = new FrameScheduler(this);
+    playbackPosition = 0;
+    artResizeTimer = new QTimer(this);
+    artResizeTimer->setSingleShot(true);
+    artResizeTimer->setInterval(ART_RESIZE_DELAY);
+    albumModel = new AlbumListModel(musicLibrary->trackStore(), this);
+    trackModel = new TrackListModel(musicLibrary->trackStore(), this);
+    artistModel = new ArtistListModel(musicLibrary->trackStore(), this);
+    artistAlbumModel = new AlbumListModel(musicLibrary->trackStore(), this);
+    artistAlbumModel->setArtist(-1);
+    connect(albumModel, &QAbstractItemModel::rowsInserted, this, &MainWindow::onAlbumsInserted);
+    connect(musicLibrary, &MusicLibrary::isLoadingChanged, this, &MainWindow::updateScanStatus);
+    connect(musicLibrary, &MusicLibrary::scanProgressChanged, this, &MainWindow::updateScanStatus);
     
     setupUI();
-    setupConnections();
 
-    // Start scanning for music files
-    qDebug() << "Starting music library scan...";
-    musicLibrary->scanMusicDirectory();
+    // The first frame is the albums page from the on-disk index; the rest
+    // of the window, the player and the rescan wait until it is out
+    musicLibrary->loadIndex();
+    albumsList->viewport()->installEventFilter(this);
 }
 
 MainWindow::~MainWindow()
@@ -91,6 +98,13 @@ void MainWindow::setupUI()
     mainContentLayout->setContentsMargins(0, 0, 0, 0);
     mainContentLayout->setSpacing(0);
 
+    // Search box above the pages
+    searchBox = new QLineEdit;
+    searchBox->setPlaceholderText("Search title, artist or album");
+    searchBox->setClearButtonEnabled(true);
+    searchBox->setStyleSheet(Theme::SEARCH_BOX_STYLE);
+    mainContentLayout->addWidget(searchBox);
+
     // Setup pages
     setupPages();
     pages->setStyleSheet(Theme::MAIN_WINDOW_STYLE + "QWidget { border: none; }");
@@ -169,7 +183,7 @@ void MainWindow::setupUI()
     miniLayout->addStretch();
 
     // Position slider
-    positionSlider = new QSlider(Qt::Horizontal, miniPlayer);
+    positionSlider = new WaveformSlider(miniPlayer);
     positionSlider->setStyleSheet(Theme::SLIDER_STYLE);
     miniLayout->addWidget(positionSlider);
 
@@ -182,6 +196,25 @@ void MainWindow::setupUI()
     // Add mini player to main content
     mainContentLayout->addWidget(miniPlayer);
 
+    // Set window properties
+    setWindowTitle("Muse");
+    resize(800, 600);
+    setStyleSheet(Theme::MAIN_WINDOW_STYLE);
+
+    // Set albums page as default
+    switchToPage(0);
+    
+    // Initialize other required labels used in updateMetadata()
+    titleLabel = miniTitleLabel;
+    artistLabel = miniArtistLabel;
+    // Create albumLabel but don't add it to any layout
+    albumLabel = new QLabel(this);
+    albumLabel->hide(); // Hide the album label
+    albumArtLabel = miniAlbumArt;
+}
+
+void MainWindow::setupFullscreenPlayer()
+{
     // Create fullscreen player
     fullscreenPlayer = new QWidget(this);
     fullscreenPlayer->setStyleSheet(Theme::FULLSCREEN_PLAYER_STYLE);
@@ -212,6 +245,7 @@ void MainWindow::setupUI()
     fullscreenAlbumArt->setMinimumSize(200, 200);
     fullscreenAlbumArt->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     fullscreenAlbumArt->setStyleSheet("background-color: palette(mid); border-radius: 10px;");
+    fullscreenAlbumArt->setAlignment(Qt::AlignCenter);
     fullscreenLayout->addWidget(fullscreenAlbumArt, 1, Qt::AlignHCenter);
 
     // Title and artist
@@ -233,7 +267,7 @@ void MainWindow::setupUI()
     fullscreenLayout->addWidget(fullscreenInfo);
 
     // Progress slider
-    fullscreenProgressSlider = new QSlider(Qt::Horizontal, fullscreenPlayer);
+    fullscreenProgressSlider = new WaveformSlider(fullscreenPlayer);
     fullscreenProgressSlider->setStyleSheet(Theme::SLIDER_STYLE);
     fullscreenLayout->addWidget(fullscreenProgressSlider);
 
@@ -284,22 +318,30 @@ void MainWindow::setupUI()
     // Add fullscreen player to the stacked widget
     pages->addWidget(fullscreenPlayer);
     fullscreenPlayer->hide(); // Initially hidden
+}
 
-    // Set window properties
-    setWindowTitle("Muse");
-    resize(800, 600);
-    setStyleSheet(Theme::MAIN_WINDOW_STYLE);
+void MainWindow::finishStartup()
+{
+    TRACE_SCOPE("finish startup");
+    if (mediaPlayer) {
+        return;
+    }
+    StartupClock::report("first frame");
 
-    // Set albums page as default
-    switchToPage(0);
-    
-    // Initialize other required labels used in updateMetadata()
-    titleLabel = miniTitleLabel;
-    artistLabel = miniArtistLabel;
-    // Create albumLabel but don't add it to any layout
-    albumLabel = new QLabel(this);
-    albumLabel->hide(); // Hide the album label
-    albumArtLabel = miniAlbumArt;
+    setupSecondaryPages();
+    setupFullscreenPlayer();
+    mediaPlayer = playbackCore->player();
+    setupConnections();
+
+    // The index selected an album before the selection was connected
+    const QModelIndex current = albumsList->currentIndex();
+    if (current.isValid()) {
+        onPlaylistPositionChanged(current.row());
+    }
+    StartupClock::report("interactive");
+
+    qDebug() << "Starting music library scan...";
+    QTimer::singleShot(0, musicLibrary, &MusicLibrary::scanMusicDirectory);
 }
 
 void MainWindow::setupSidebar()
@@ -340,32 +382,63 @@ void MainWindow::setupPages()
     albumsPage->setStyleSheet("QWidget { background: transparent; border: none; }");
     QVBoxLayout *albumsLayout = new QVBoxLayout(albumsPage);
     albumsLayout->setContentsMargins(0, 0, 0, 0);
-    albumsList = new QListWidget;
-    albumsList->setStyleSheet(Theme::LIST_WIDGET_STYLE + "QListWidget { border: none; }");
+    QHBoxLayout *albumsHeader = new QHBoxLayout;
+    albumsHeader->setContentsMargins(8, 4, 8, 0);
+    albumsHeader->addStretch();
+    albumsGridButton = new QToolButton;
+    albumsGridButton->setCheckable(true);
+    albumsGridButton->setChecked(true);
+    albumsGridButton->setIcon(QIcon::fromTheme("view-grid"));
+    albumsGridButton->setToolTip("Show album covers");
+    albumsGridButton->setStyleSheet(Theme::TOOL_BUTTON_STYLE);
+    albumsHeader->addWidget(albumsGridButton);
+    albumsLayout->addLayout(albumsHeader);
+    albumsList = new AlbumGridView;
+    albumsList->setModel(albumModel);
+    albumsList->setStyleSheet(Theme::LIST_WIDGET_STYLE + "QListView { border: none; }");
+    albumsList->setGridMode(true);
     albumsLayout->addWidget(albumsList);
     pages->addWidget(albumsPage);
     
     // Initialize playlistWidget to albumsList
     playlistWidget = albumsList;
 
+    // Set albums page as default
+    switchToPage(0);
+}
+
+void MainWindow::setupSecondaryPages()
+{
+    // Added after the albums page, in the order the sidebar expects
+
     // Tracks page (now secondary)
     tracksPage = new QWidget;
     tracksPage->setStyleSheet("QWidget { background: transparent; border: none; }");
     QVBoxLayout *tracksLayout = new QVBoxLayout(tracksPage);
     tracksLayout->setContentsMargins(0, 0, 0, 0);
-    tracksList = new QListWidget;
-    tracksList->setStyleSheet(Theme::LIST_WIDGET_STYLE + "QListWidget { border: none; }");
+    tracksList = new QListView;
+    tracksList->setUniformItemSizes(true);
+    tracksList->setModel(trackModel);
+    tracksList->setStyleSheet(Theme::LIST_WIDGET_STYLE + "QListView { border: none; }");
     tracksLayout->addWidget(tracksList);
     pages->addWidget(tracksPage);
 
     // Artists page
     artistsPage = new QWidget;
     artistsPage->setStyleSheet("QWidget { background: transparent; border: none; }");
-    QVBoxLayout *artistsLayout = new QVBoxLayout(artistsPage);
+    QHBoxLayout *artistsLayout = new QHBoxLayout(artistsPage);
     artistsLayout->setContentsMargins(0, 0, 0, 0);
-    artistsList = new QListWidget;
-    artistsList->setStyleSheet(Theme::LIST_WIDGET_STYLE + "QListWidget { border: none; }");
-    artistsLayout->addWidget(artistsList);
+    artistsLayout->setSpacing(0);
+    artistsList = new QListView;
+    artistsList->setUniformItemSizes(true);
+    artistsList->setModel(artistModel);
+    artistsList->setStyleSheet(Theme::LIST_WIDGET_STYLE + "QListView { border: none; }");
+    artistsLayout->addWidget(artistsList, 1);
+    artistAlbumsList = new QListView;
+    artistAlbumsList->setUniformItemSizes(true);
+    artistAlbumsList->setModel(artistAlbumModel);
+    artistAlbumsList->setStyleSheet(Theme::LIST_WIDGET_STYLE + "QListView { border: none; }");
+    artistsLayout->addWidget(artistAlbumsList, 1);
     pages->addWidget(artistsPage);
 
     // Playlists page
@@ -373,13 +446,11 @@ void MainWindow::setupPages()
     playlistsPage->setStyleSheet("QWidget { background: transparent; border: none; }");
     QVBoxLayout *playlistsLayout = new QVBoxLayout(playlistsPage);
     playlistsLayout->setContentsMargins(0, 0, 0, 0);
-    playlistsList = new QListWidget;
-    playlistsList->setStyleSheet(Theme::LIST_WIDGET_STYLE + "QListWidget { border: none; }");
+    playlistsList = new QListView;
+    playlistsList->setUniformItemSizes(true);
+    playlistsList->setStyleSheet(Theme::LIST_WIDGET_STYLE + "QListView { border: none; }");
     playlistsLayout->addWidget(playlistsList);
     pages->addWidget(playlistsPage);
-
-    // Set albums page as default
-    switchToPage(0);
 }
 
 void MainWindow::switchToPage(int index)
@@ -398,10 +469,19 @@ void MainWindow::onNavigationButtonClicked(int index)
 void MainWindow::setupConnections()
 {
     // Connect media player signals
-    connect(mediaPlayer, &QMediaPlayer::positionChanged, this, &MainWindow::onPositionChanged);
-    connect(mediaPlayer, &QMediaPlayer::durationChanged, this, &MainWindow::onDurationChanged);
-    connect(mediaPlayer, &QMediaPlayer::playbackStateChanged, this, &MainWindow::updatePlayPauseButton);
-    connect(mediaPlayer, &QMediaPlayer::errorOccurred, this, [this](QMediaPlayer::Error error, const QString &errorString) {
+    connect(mediaPlayer, &PlaybackBackend::positionChanged, this, &MainWindow::onPositionChanged);
+    connect(frameScheduler, &FrameScheduler::frame, this, &MainWindow::updatePlaybackFrame);
+    connect(artLoader, &ArtLoader::ready, this, &MainWindow::onArtReady);
+    connect(artResizeTimer, &QTimer::timeout, this, [this]() {
+        if (fullscreenPlayer->isVisible()) {
+            updateFullscreenArt();
+        }
+    });
+    connect(mediaPlayer, &PlaybackBackend::durationChanged, this, &MainWindow::onDurationChanged);
+    connect(mediaPlayer, &PlaybackBackend::playbackStateChanged, this, &MainWindow::updatePlayPauseButton);
+    connect(mediaPlayer, &PlaybackBackend::currentIndexChanged, this, &MainWindow::onQueueIndexChanged);
+    connect(playbackCore, &PlaybackCore::nowPlayingChanged, this, &MainWindow::updateMetadata);
+    connect(mediaPlayer, &PlaybackBackend::errorOccurred, this, [this](QMediaPlayer::Error error, const QString &errorString) {
         qDebug() << "Media player error:" << error << errorString;
         // Reset UI to a safe state
         updatePlayPauseButton();
@@ -411,49 +491,51 @@ void MainWindow::setupConnections()
     });
 
     // Connect playlist signals
-    connect(playlistWidget, &QListWidget::currentRowChanged, this, &MainWindow::onPlaylistPositionChanged);
-    connect(playlistWidget, &QListWidget::itemDoubleClicked, this, &MainWindow::onItemDoubleClicked);
-    connect(musicLibrary, &MusicLibrary::audioFilesChanged, this, &MainWindow::onAudioFilesChanged);
+    connect(playlistWidget->selectionModel(), &QItemSelectionModel::currentRowChanged,
+            this, [this](const QModelIndex &current) {
+        onPlaylistPositionChanged(current.row());
+    });
+    connect(playlistWidget, &QAbstractItemView::doubleClicked, this, &MainWindow::onItemDoubleClicked);
+    connect(albumsGridButton, &QToolButton::toggled, albumsList, &AlbumGridView::setGridMode);
+    connect(tracksList, &QAbstractItemView::doubleClicked, this, &MainWindow::onItemDoubleClicked);
+    connect(artistAlbumsList, &QAbstractItemView::doubleClicked, this, &MainWindow::onItemDoubleClicked);
+
+    // Selecting an artist lists its albums straight from the artist index
+    connect(artistsList->selectionModel(), &QItemSelectionModel::currentRowChanged,
+            this, [this](const QModelIndex &current) {
+        artistAlbumModel->setArtist(current.isValid() ? artistModel->artistId(current.row()) : -1);
+    });
+    connect(searchBox, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
 
     // Connect control buttons
     connect(playPauseButton, &QPushButton::clicked, this, &MainWindow::onPlayPauseClicked);
     connect(nextButton, &QPushButton::clicked, this, &MainWindow::onNextClicked);
     connect(previousButton, &QPushButton::clicked, this, &MainWindow::onPreviousClicked);
     
-    // Connect position slider signals
-    connect(positionSlider, &QSlider::sliderPressed, this, [this]() {
-        // Store the current playback state
-        wasPlaying = mediaPlayer->playbackState() == QMediaPlayer::PlayingState;
-        if (wasPlaying) {
-            mediaPlayer->pause();
-        }
-    });
-    
+    // A seek restarts the decoder, so a drag only moves the handle and
+    // playback carries on until it is let go
     connect(positionSlider, &QSlider::sliderReleased, this, [this]() {
-        // Set the new position
         mediaPlayer->setPosition(positionSlider->value());
-        // Resume playback if it was playing before
-        if (wasPlaying) {
-            mediaPlayer->play();
-        }
-    });
-    
-    connect(positionSlider, &QSlider::sliderMoved, this, [this](int value) {
-        // Update the position in real-time while dragging
-        mediaPlayer->setPosition(value);
     });
 
-    // Install event filter for position slider to handle mouse clicks
-    positionSlider->installEventFilter(this);
-
     // Connect fullscreen player controls
     connect(fullscreenPlayPauseButton, &QPushButton::clicked, this, &MainWindow::onPlayPauseClicked);
     connect(fullscreenNextButton, &QPushButton::clicked, this, &MainWindow::onNextClicked);
     connect(fullscreenPreviousButton, &QPushButton::clicked, this, &MainWindow::onPreviousClicked);
-    connect(fullscreenProgressSlider, &QSlider::sliderMoved, mediaPlayer, &QMediaPlayer::setPosition);
+    connect(fullscreenProgressSlider, &QSlider::sliderReleased, this, [this]() {
+        mediaPlayer->setPosition(fullscreenProgressSlider->value());
+    });
 
-    // Install event filter for fullscreen progress slider
-    fullscreenProgressSlider->installEventFilter(this);
+    // Show the playing track's waveform once it is loaded or generated
+    connect(waveformGenerator, &WaveformGenerator::ready, this, [this](const QString &filePath, const Waveform &waveform) {
+        const int index = mediaPlayer->currentIndex();
+        if (index < 0 || index >= queueTracks.size()
+                || musicLibrary->trackStore()->filePath(queueTracks.at(index)) != filePath) {
+            return;
+        }
+        positionSlider->setWaveform(waveform);
+        fullscreenProgressSlider->setWaveform(waveform);
+    });
 
     // Install event filter for mini player click events
     miniPlayer->installEventFilter(this);
@@ -461,6 +543,11 @@ void MainWindow::setupConnections()
 
 bool MainWindow::eventFilter(QObject *obj, QEvent *event)
 {
+    if (obj == albumsList->viewport() && event->type() == QEvent::Paint) {
+        // Finish on the next pass of the event loop, after this frame
+        albumsList->viewport()->removeEventFilter(this);
+        QTimer::singleShot(0, this, &MainWindow::finishStartup);
+    }
     if (obj == miniPlayer && event->type() == QEvent::MouseButtonPress) {
         // Toggle the fullscreen player instead of just showing it
         if (fullscreenPlayer->isVisible()) {
@@ -470,31 +557,6 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
         }
         return true;
     }
-    else if ((obj == positionSlider || obj == fullscreenProgressSlider) && event->type() == QEvent::MouseButtonPress) {
-        QMouseEvent *mouseEvent = static_cast<QMouseEvent*>(event);
-        if (mouseEvent->button() == Qt::LeftButton) {
-            QSlider *slider = qobject_cast<QSlider*>(obj);
-            // Calculate the position based on the mouse click
-            double pos = mouseEvent->position().x() / slider->width();
-            int value = pos * slider->maximum();
-            slider->setValue(value);
-            
-            // Store the current playback state
-            wasPlaying = mediaPlayer->playbackState() == QMediaPlayer::PlayingState;
-            if (wasPlaying) {
-                mediaPlayer->pause();
-            }
-            
-            // Set the new position
-            mediaPlayer->setPosition(value);
-            
-            // Resume playback if it was playing before
-            if (wasPlaying) {
-                mediaPlayer->play();
-            }
-            return true;
-        }
-    }
     return QMainWindow::eventFilter(obj, event);
 }
 
@@ -519,45 +581,8 @@ void MainWindow::showFullscreenPlayer()
         // Switch to the fullscreen player page
         pages->setCurrentIndex(fullscreenIndex);
         
-        // Calculate the album art size based on the window size
-        int albumSize = qMin(width(), height()) / 2;
-        
-        // Set both minimum and maximum size for the album art
-        fullscreenAlbumArt->setMinimumSize(albumSize, albumSize);
-        fullscreenAlbumArt->setMaximumSize(albumSize, albumSize);
-        
-        // Get the current file path and extract album art at full resolution
-        QString currentFile = mediaPlayer->source().toLocalFile();
-        QImage albumArt = extractAlbumArt(currentFile);
-        
-        if (!albumArt.isNull()) {
-            // Create a pixmap with transparency
-            QPixmap scaledPixmap(albumSize, albumSize);
-            scaledPixmap.fill(Qt::transparent);
-            
-            // Create a painter to draw the scaled image
-            QPainter painter(&scaledPixmap);
-            painter.setRenderHint(QPainter::SmoothPixmapTransform);
-            
-            // Scale the image maintaining aspect ratio
-            QImage scaledImage = albumArt.scaled(
-                albumSize, 
-                albumSize,
-                Qt::KeepAspectRatio,
-                Qt::SmoothTransformation
-            );
-            
-            // Calculate position to center the image
-            int x = (albumSize - scaledImage.width()) / 2;
-            int y = (albumSize - scaledImage.height()) / 2;
-            
-            // Draw the image centered
-            painter.drawImage(x, y, scaledImage);
-            painter.end();
-            
-            // Set the pixmap
-            fullscreenAlbumArt->setPixmap(scaledPixmap);
-        }
+        // Album art at the size matching the window
+        updateFullscreenArt();
         
         // Calculate control sizes based on window size
         int baseSize = qMin(width(), height());
@@ -635,27 +660,45 @@ void MainWindow::onPlayPauseClicked()
 
 void MainWindow::onNextClicked()
 {
-    int nextRow = playlistWidget->currentRow() + 1;
-    if (nextRow < playlistWidget->count()) {
-        playlistWidget->setCurrentRow(nextRow);
+    // Step through the play queue; past its end, move on to the next album
+    if (mediaPlayer->hasNext()) {
+        mediaPlayer->next();
+        return;
+    }
+    QAbstractItemModel *model = playlistWidget->model();
+    int nextRow = playlistWidget->currentIndex().row() + 1;
+    if (nextRow < model->rowCount()) {
+        playlistWidget->setCurrentIndex(model->index(nextRow, 0));
     }
 }
 
 void MainWindow::onPreviousClicked()
 {
-    int prevRow = playlistWidget->currentRow() - 1;
+    if (mediaPlayer->hasPrevious()) {
+        mediaPlayer->previous();
+        return;
+    }
+    QAbstractItemModel *model = playlistWidget->model();
+    int prevRow = playlistWidget->currentIndex().row() - 1;
     if (prevRow >= 0) {
-        playlistWidget->setCurrentRow(prevRow);
+        playlistWidget->setCurrentIndex(model->index(prevRow, 0));
     }
 }
 
 void MainWindow::onPositionChanged(qint64 position)
+{
+    // Widgets follow on the next display frame, however often this comes
+    playbackPosition = position;
+    frameScheduler->schedule();
+}
+
+void MainWindow::updatePlaybackFrame()
 {
     if (!positionSlider->isSliderDown()) {
-        positionSlider->setValue(position);
+        positionSlider->setValue(playbackPosition);
     }
     if (!fullscreenProgressSlider->isSliderDown()) {
-        fullscreenProgressSlider->setValue(position);
+        fullscreenProgressSlider->setValue(playbackPosition);
     }
 }
 
@@ -668,65 +711,99 @@ void MainWindow::onDurationChanged(qint64 duration)
 void MainWindow::onPlaylistPositionChanged(int position)
 {
     if (position >= 0) {
-        QString filePath;
         if (playlistWidget == albumsList) {
-            // If we're in the albums view, get the first track of the selected album
-            QListWidgetItem *albumItem = albumsList->item(position);
-            if (albumItem) {
-                QStringList albumFiles = albumItem->data(Qt::UserRole).toStringList();
-                if (!albumFiles.isEmpty()) {
-                    filePath = albumFiles.first();
-                }
-            }
-        } else {
-            // If we're in the tracks view, get the selected track
-            if (position < musicLibrary->audioFiles().size()) {
-                filePath = musicLibrary->audioFiles()[position];
+            // If we're in the albums view, queue the selected album from its first track
+            if (position < albumModel->rowCount() && !albumModel->tracks(position).isEmpty()) {
+                setPlayQueue(albumModel->tracks(position), 0);
             }
+        } else if (position < trackModel->rowCount()) {
+            // If we're in the tracks view, queue the list from the selected track
+            setPlayQueue(trackModel->tracks(), position);
         }
+    }
+}
 
-        if (!filePath.isEmpty()) {
-            QUrl url = QUrl::fromLocalFile(filePath);
-            if (url.isValid()) {
-                mediaPlayer->setSource(url);
-                updateMetadata();
-            }
-        }
+void MainWindow::setPlayQueue(const QVector<int> &tracks, int index)
+{
+    TrackStore *store = musicLibrary->trackStore();
+    QList<QUrl> urls;
+    QList<LoudnessInfo> loudness;
+    urls.reserve(tracks.size());
+    loudness.reserve(tracks.size());
+    for (int id : tracks) {
+        urls.append(QUrl::fromLocalFile(store->filePath(id)));
+        loudness.append(store->loudness(id));
     }
+    queueTracks = tracks;
+    mediaPlayer->setQueue(urls, index, loudness);
 }
 
-void MainWindow::onAudioFilesChanged(const QStringList& files)
+void MainWindow::onQueueIndexChanged(int index)
 {
-    // Clear both lists
-    albumsList->clear();
-    tracksList->clear();
-    
-    // Group files by album
-    QMap<QString, QStringList> albumMap;
-    for (const QString &filePath : files) {
-        TagLib::FileRef file(filePath.toUtf8().constData());
-        if (!file.isNull()) {
-            TagLib::Tag *tag = file.tag();
-            if (tag) {
-                QString album = QString::fromStdString(tag->album().toCString(true));
-                if (album.isEmpty()) {
-                    album = "Unknown Album";
-                }
-                albumMap[album].append(filePath);
-            }
-        }
+    TRACE_SCOPE("track switch");
+    positionSlider->clearWaveform();
+    fullscreenProgressSlider->clearWaveform();
+    if (index >= 0 && index < queueTracks.size()) {
+        const TrackInfo track = musicLibrary->trackStore()->track(queueTracks.at(index));
+        waveformGenerator->request(track.filePath, track.size, track.modified);
     }
 
-    // Add albums to the albums list
-    for (auto it = albumMap.begin(); it != albumMap.end(); ++it) {
-        QListWidgetItem *item = new QListWidgetItem(it.key());
-        item->setData(Qt::UserRole, it.value()); // Store the file paths
-        albumsList->addItem(item);
+    // Keep the track list's selection on the playing entry when it shows the queue
+    const QVector<int> &shown = trackModel->tracks();
+    if (index >= 0 && index < shown.size() && index < queueTracks.size()
+            && shown.at(index) == queueTracks.at(index)) {
+        tracksList->setCurrentIndex(trackModel->index(index));
     }
+}
 
+void MainWindow::onAlbumsInserted()
+{
     // If we have albums but no selection, select the first one
-    if (albumsList->count() > 0 && albumsList->currentRow() < 0) {
-        albumsList->setCurrentRow(0);
+    if (albumModel->rowCount() > 0 && !albumsList->currentIndex().isValid()) {
+        albumsList->setCurrentIndex(albumModel->index(0));
+    }
+}
+
+void MainWindow::onSearchTextChanged(const QString &text)
+{
+    if (text.isEmpty()) {
+        // Back to the list the search replaced
+        if (searching) {
+            trackModel->setTracks(tracksBeforeSearch);
+            tracksBeforeSearch.clear();
+            searching = false;
+        }
+        return;
+    }
+    if (!searching) {
+        tracksBeforeSearch = trackModel->tracks();
+        searching = true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<int> results = musicLibrary->searchIndex()->search(text);
+    const qint64 elapsed = timer.nsecsElapsed() / 1000;
+    if (elapsed > SEARCH_BUDGET) {
+        qCWarning(lcLibrary) << "Search for" << text << "matched" << results.size()
+                             << "tracks in" << elapsed << "us, over the" << SEARCH_BUDGET << "us budget";
+    } else {
+        qCDebug(lcLibrary) << "Search for" << text << "matched" << results.size()
+                           << "tracks in" << elapsed << "us";
+    }
+
+    trackModel->setTracks(results);
+    pages->setCurrentWidget(tracksPage);
+}
+
+void MainWindow::updateScanStatus()
+{
+    if (musicLibrary->isLoading()) {
+        setWindowTitle(QString("Muse - Scanning (%1 of %2 folders)")
+                       .arg(musicLibrary->scannedDirectories())
+                       .arg(musicLibrary->queuedDirectories()));
+    } else {
+        setWindowTitle("Muse");
     }
 }
 
@@ -744,69 +821,20 @@ void MainWindow::updatePlayPauseButton()
     }
 }
 
-QImage MainWindow::extractAlbumArt(const QString &filePath)
-{
-    QImage albumArt;
-    TagLib::FileRef file(filePath.toUtf8().constData());
-    
-    if (!file.isNull()) {
-        TagLib::Tag *tag = file.tag();
-        if (!tag) return albumArt;
-
-        // Try to get the cover art based on file type
-        if (TagLib::MPEG::File *mpegFile = dynamic_cast<TagLib::MPEG::File*>(file.file())) {
-            if (mpegFile->ID3v2Tag()) {
-                TagLib::ID3v2::FrameList frames = mpegFile->ID3v2Tag()->frameList("APIC");
-                if (!frames.isEmpty()) {
-                    TagLib::ID3v2::AttachedPictureFrame *frame = 
-                        dynamic_cast<TagLib::ID3v2::AttachedPictureFrame*>(frames.front());
-                    if (frame) {
-                        albumArt.loadFromData((const uchar*)frame->picture().data(), 
-                                           frame->picture().size());
-                    }
-                }
-            }
-        }
-        else if (TagLib::FLAC::File *flacFile = dynamic_cast<TagLib::FLAC::File*>(file.file())) {
-            const TagLib::List<TagLib::FLAC::Picture*>& pictures = flacFile->pictureList();
-            if (!pictures.isEmpty()) {
-                TagLib::FLAC::Picture* picture = pictures.front();
-                albumArt.loadFromData((const uchar*)picture->data().data(), 
-                                   picture->data().size());
-            }
-        }
-        else if (TagLib::MP4::File *mp4File = dynamic_cast<TagLib::MP4::File*>(file.file())) {
-            TagLib::MP4::Tag *mp4Tag = mp4File->tag();
-            if (mp4Tag) {
-                const TagLib::MP4::ItemMap& itemsMap = mp4Tag->itemMap();
-                if (itemsMap.contains("covr")) {
-                    const TagLib::MP4::CoverArtList& coverArtList = 
-                        itemsMap["covr"].toCoverArtList();
-                    if (!coverArtList.isEmpty()) {
-                        albumArt.loadFromData((const uchar*)coverArtList[0].data().data(), 
-                                           coverArtList[0].data().size());
-                    }
-                }
-            }
-        }
-    }
-    
-    return albumArt;
-}
-
 void MainWindow::updateMetadata()
 {
+    TRACE_SCOPE("update now playing");
     try {
-        QString filePath = mediaPlayer->source().toLocalFile();
-        TagLib::FileRef file(filePath.toUtf8().constData());
+        const TrackInfo &info = playbackCore->nowPlaying();
+        const QString filePath = info.filePath;
+        currentTrack = info;
         
-        if (!file.isNull()) {
-            TagLib::Tag *tag = file.tag();
-            if (tag) {
+        if (info.isValid()) {
+            if (info.hasTags) {
                 // Get basic metadata
-                QString title = QString::fromStdString(tag->title().toCString(true));
-                QString artist = QString::fromStdString(tag->artist().toCString(true));
-                QString album = QString::fromStdString(tag->album().toCString(true));
+                QString title = info.title;
+                QString artist = info.artist;
+                QString album = info.album;
                 
                 // Set fallback values if metadata is empty
                 if (title.isEmpty()) {
@@ -828,21 +856,7 @@ void MainWindow::updateMetadata()
                 fullscreenTitleLabel->setText(title);
                 fullscreenArtistLabel->setText(artist);
                 
-                // Get album art
-                QImage albumArt = extractAlbumArt(filePath);
-                if (!albumArt.isNull()) {
-                    QPixmap pixmap = QPixmap::fromImage(albumArt);
-                    albumArtLabel->setPixmap(pixmap.scaled(300, 300, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-                    miniAlbumArt->setPixmap(pixmap.scaled(50, 50, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-                    
-                    // Update fullscreen album art
-                    int albumSize = qMin(fullscreenPlayer->width(), fullscreenPlayer->height()) / 2;
-                    fullscreenAlbumArt->setPixmap(pixmap.scaled(albumSize, albumSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-                } else {
-                    albumArtLabel->setText("No Album Art");
-                    miniAlbumArt->setText("No Art");
-                    fullscreenAlbumArt->setText("No Album Art");
-                }
+                showArt();
             }
         }
     } catch (const std::exception& e) {
@@ -861,31 +875,25 @@ void MainWindow::updateMetadata()
     }
 }
 
-void MainWindow::onItemDoubleClicked(QListWidgetItem *item)
+void MainWindow::onItemDoubleClicked(const QModelIndex &index)
 {
-    if (item->listWidget() == albumsList) {
-        // Get the list of files for this album
-        QStringList albumFiles = item->data(Qt::UserRole).toStringList();
-        
-        // Clear the tracks list and add all tracks from the album
-        tracksList->clear();
-        for (const QString &filePath : albumFiles) {
-            QFileInfo fileInfo(filePath);
-            QString fileName = fileInfo.fileName();
-            QListWidgetItem *trackItem = new QListWidgetItem(fileName);
-            trackItem->setData(Qt::UserRole, filePath);
-            tracksList->addItem(trackItem);
-        }
-        
-        // Start playing the first track
-        if (tracksList->count() > 0) {
-            tracksList->setCurrentRow(0);
-            QString firstTrack = tracksList->item(0)->data(Qt::UserRole).toString();
-            mediaPlayer->setSource(QUrl::fromLocalFile(firstTrack));
+    if (const AlbumListModel *albums = qobject_cast<const AlbumListModel *>(index.model())) {
+        // Show this album's tracks; the model only copies the track ids.
+        // Clearing a search leaves them shown
+        trackModel->setTracks(albums->tracks(index.row()));
+        searching = false;
+        
+        // Queue the album and start playing the first track
+        if (trackModel->rowCount() > 0) {
+            tracksList->setCurrentIndex(trackModel->index(0));
+            setPlayQueue(trackModel->tracks(), 0);
             mediaPlayer->play();
         }
     } else {
-        // Handle track item click (existing behavior)
+        // Play the track that was clicked, then the rest of the list after it
+        if (index.row() < trackModel->rowCount()) {
+            setPlayQueue(trackModel->tracks(), index.row());
+        }
         mediaPlayer->setPosition(0);
         mediaPlayer->play();
     }
@@ -905,136 +913,77 @@ void MainWindow::resizeEvent(QResizeEvent *event)
     QMainWindow::resizeEvent(event);
     
     // If the fullscreen player is visible, update its size
-    if (fullscreenPlayer->isVisible()) {
+    if (fullscreenPlayer && fullscreenPlayer->isVisible()) {
         fullscreenPlayer->setGeometry(0, 0, width(), height());
-        
-        // Calculate the album art size based on the window size
-        int albumSize = qMin(width(), height()) / 2;
-        
-        // Set both minimum and maximum size for the album art
-        fullscreenAlbumArt->setMinimumSize(albumSize, albumSize);
-        fullscreenAlbumArt->setMaximumSize(albumSize, albumSize);
-        
-        // Get the current file path and extract album art at full resolution
-        QString currentFile = mediaPlayer->source().toLocalFile();
-        QImage albumArt = extractAlbumArt(currentFile);
-        
-        if (!albumArt.isNull()) {
-            // Create a pixmap with transparency
-            QPixmap scaledPixmap(albumSize, albumSize);
-            scaledPixmap.fill(Qt::transparent);
-            
-            // Create a painter to draw the scaled image
-            QPainter painter(&scaledPixmap);
-            painter.setRenderHint(QPainter::SmoothPixmapTransform);
-            
-            // Scale the image maintaining aspect ratio
-            QImage scaledImage = albumArt.scaled(
-                albumSize, 
-                albumSize,
-                Qt::KeepAspectRatio,
-                Qt::SmoothTransformation
-            );
-            
-            // Calculate position to center the image
-            int x = (albumSize - scaledImage.width()) / 2;
-            int y = (albumSize - scaledImage.height()) / 2;
-            
-            // Draw the image centered
-            painter.drawImage(x, y, scaledImage);
-            painter.end();
-            
-            // Set the pixmap
-            fullscreenAlbumArt->setPixmap(scaledPixmap);
-        }
+
+        // While the edge is being dragged the art is only roughly scaled;
+        // each event pushes the smooth version back, so only the final
+        // size gets one
+        updateFullscreenArt(true);
+        artResizeTimer->start();
     }
 }
 
-void MainWindow::updateNowPlayingInfo()
+void MainWindow::showArt()
 {
-    const QMediaMetaData metaData = mediaPlayer->metaData();
-    
-    // Get title
-    QString title = metaData.stringValue(QMediaMetaData::Title);
-    if (title.isEmpty()) {
-        QFileInfo fileInfo(mediaPlayer->source().toLocalFile());
-        title = fileInfo.baseName();
+    if (!artCache.hasArt(currentTrack)) {
+        albumArtLabel->setText("No Album Art");
+        miniAlbumArt->setText("No Art");
+        fullscreenAlbumArt->setText("No Album Art");
+        return;
     }
-    
-    // Get artist
-    QString artist = metaData.stringValue(QMediaMetaData::AlbumArtist);
-    if (artist.isEmpty()) {
-        artist = metaData.stringValue(QMediaMetaData::ContributingArtist);
+
+    const QPixmap miniArt = artCache.pixmap(currentTrack, 50);
+    if (miniArt.isNull()) {
+        // Nothing from the last track stays up while this one's is decoded
+        miniAlbumArt->clear();
+        fullscreenAlbumArt->clear();
+        QList<int> sizes = {50};
+        if (fullscreenPlayer->isVisible()) {
+            sizes.append(qMin(width(), height()) / 2);
+        }
+        artLoader->request(currentTrack, sizes, artCache.source(currentTrack));
+        return;
     }
-    if (artist.isEmpty()) {
-        artist = "Unknown Artist";
+
+    // albumArtLabel is the mini player label, so one pixmap serves both
+    miniAlbumArt->setPixmap(miniArt);
+    if (fullscreenPlayer->isVisible()) {
+        updateFullscreenArt();
     }
+}
 
-    // Update labels
-    miniTitleLabel->setText(title);
-    miniArtistLabel->setText(artist);
-    fullscreenTitleLabel->setText(title);
-    fullscreenArtistLabel->setText(artist);
-
-    // Handle album art
-    QImage albumArt;
-    QVariant artData = metaData.value(QMediaMetaData::ThumbnailImage);
-    if (!artData.isValid()) {
-        artData = metaData.value(QMediaMetaData::CoverArtImage);
+void MainWindow::onArtReady(const QString &artKey, const QImage &source, const QHash<int, QImage> &scaled)
+{
+    artCache.insert(artKey, source, scaled);
+    if (artKey == currentTrack.artKey()) {
+        showArt();
     }
+}
+
+void MainWindow::updateFullscreenArt(bool preview)
+{
+    // Calculate the album art size based on the window size
+    int albumSize = qMin(width(), height()) / 2;
     
-    if (artData.isValid()) {
-        albumArt = artData.value<QImage>();
+    // Set both minimum and maximum size for the album art
+    fullscreenAlbumArt->setMinimumSize(albumSize, albumSize);
+    fullscreenAlbumArt->setMaximumSize(albumSize, albumSize);
+    
+    if (!currentTrack.isValid() || !artCache.hasArt(currentTrack)) {
+        return;
     }
-
-    if (!albumArt.isNull()) {
-        // Mini player album art
-        QPixmap miniArtPixmap = QPixmap::fromImage(albumArt)
-            .scaled(60, 60, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        
-        // Create a rounded version of the mini art
-        QPixmap roundedMiniArt(60, 60);
-        roundedMiniArt.fill(Qt::transparent);
-        
-        QPainter painter(&roundedMiniArt);
-        painter.setRenderHint(QPainter::Antialiasing);
-        
-        QPainterPath path;
-        path.addRoundedRect(0, 0, 60, 60, 5, 5);
-        painter.setClipPath(path);
-        
-        // Center the artwork in the rounded frame
-        int x = (60 - miniArtPixmap.width()) / 2;
-        int y = (60 - miniArtPixmap.height()) / 2;
-        painter.drawPixmap(x, y, miniArtPixmap);
-        
-        miniAlbumArt->setPixmap(roundedMiniArt);
-
-        // Fullscreen album art
-        int fullscreenSize = qMin(fullscreenAlbumArt->width(), fullscreenAlbumArt->height());
-        QPixmap fullscreenArtPixmap = QPixmap::fromImage(albumArt)
-            .scaled(fullscreenSize, fullscreenSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        
-        // Create a rounded version of the fullscreen art
-        QPixmap roundedFullscreenArt(fullscreenSize, fullscreenSize);
-        roundedFullscreenArt.fill(Qt::transparent);
-        
-        QPainter fullscreenPainter(&roundedFullscreenArt);
-        fullscreenPainter.setRenderHint(QPainter::Antialiasing);
-        
-        QPainterPath fullscreenPath;
-        fullscreenPath.addRoundedRect(0, 0, fullscreenSize, fullscreenSize, 10, 10);
-        fullscreenPainter.setClipPath(fullscreenPath);
-        
-        // Center the artwork in the rounded frame
-        x = (fullscreenSize - fullscreenArtPixmap.width()) / 2;
-        y = (fullscreenSize - fullscreenArtPixmap.height()) / 2;
-        fullscreenPainter.drawPixmap(x, y, fullscreenArtPixmap);
-        
-        fullscreenAlbumArt->setPixmap(roundedFullscreenArt);
-    } else {
-        // Set placeholder images
-        miniAlbumArt->setPixmap(QIcon::fromTheme("media-optical-audio").pixmap(60, 60));
-        fullscreenAlbumArt->setPixmap(QIcon::fromTheme("media-optical-audio").pixmap(200, 200));
+    
+    // Scaled variants come from memory. A size not made yet is scaled
+    // smoothly in the background, with a rough version until then
+    QPixmap art = preview ? QPixmap() : artCache.pixmap(currentTrack, albumSize);
+    if (art.isNull()) {
+        art = artCache.preview(currentTrack, albumSize);
+        if (!preview) {
+            artLoader->request(currentTrack, {albumSize}, artCache.source(currentTrack));
+        }
     }
-} 
\ No newline at end of file
+    if (!art.isNull()) {
+        fullscreenAlbumArt->setPixmap(art);
+    }
+}
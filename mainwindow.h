@@ -3,8 +3,8 @@
 
 #include <QMainWindow>
 #include <QMediaPlayer>
-#include <QAudioOutput>
-#include <QListWidget>
+#include <QListView>
+#include <QLineEdit>
 #include <QPushButton>
 #include <QLabel>
 #include <QSlider>
@@ -16,14 +16,25 @@
 #include <QFrame>
 #include <QPropertyAnimation>
 #include <QGraphicsOpacityEffect>
+#include <QTimer>
 #include "musiclibrary.h"
+#include "albumartcache.h"
+#include "artloader.h"
+#include "albumlistmodel.h"
+#include "albumgridview.h"
+#include "tracklistmodel.h"
+#include "artistlistmodel.h"
+#include "playbackcore.h"
+#include "framescheduler.h"
+#include "waveformgenerator.h"
+#include "waveformslider.h"
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    MainWindow(PlaybackCore *core, QWidget *parent = nullptr);
     ~MainWindow();
 
 protected:
@@ -37,38 +48,58 @@ private slots:
     void onPositionChanged(qint64 position);
     void onDurationChanged(qint64 duration);
     void onPlaylistPositionChanged(int position);
-    void onItemDoubleClicked(QListWidgetItem* item);
-    void onAudioFilesChanged(const QStringList& files);
+    void onQueueIndexChanged(int index);
+    void onItemDoubleClicked(const QModelIndex &index);
+    void onAlbumsInserted();
+    void onSearchTextChanged(const QString &text);
+    void updateScanStatus();
     void onNavigationButtonClicked(int index);
     void onMiniPlayerClicked();
+    void onArtReady(const QString &artKey, const QImage &source, const QHash<int, QImage> &scaled);
 
 private:
+    // Builds what the first frame shows; finishStartup() does the rest
+    // once it is out
     void setupUI();
+    void finishStartup();
+    void setupSecondaryPages();
+    void setupFullscreenPlayer();
     void setupConnections();
     void updatePlayPauseButton();
+    void updatePlaybackFrame();
     void showFullscreenPlayer();
     void hideFullscreenPlayer();
-    void updateNowPlayingInfo();
     void updateMetadata();
-    QImage extractAlbumArt(const QString &filePath);
+    void updateFullscreenArt(bool preview = false);
+    void showArt();
     void setupSidebar();
     void setupPages();
     void switchToPage(int index);
+    void setPlayQueue(const QVector<int> &tracks, int index);
 
     // Main UI components
     QWidget *centralWidget;
     QVBoxLayout *mainLayout;
-    QMediaPlayer *mediaPlayer;
-    QAudioOutput *audioOutput;
+    PlaybackCore *playbackCore;
+    PlaybackBackend *mediaPlayer;  // playbackCore's, null until finishStartup()
+    QVector<int> queueTracks;  // track ids behind mediaPlayer's queue
+    QVector<int> tracksBeforeSearch;  // the track list while searching replaces it
+    bool searching;
+    FrameScheduler *frameScheduler;
+    QTimer *artResizeTimer;    // smooth art once a resize has settled
+    qint64 playbackPosition;   // latest from mediaPlayer, shown on the next frame
+    WaveformGenerator *waveformGenerator;
     MusicLibrary *musicLibrary;
-    QListWidget *playlistWidget;
+    AlbumArtCache artCache;
+    ArtLoader *artLoader;
+    TrackInfo currentTrack;
+    QListView *playlistWidget;
     QPushButton *playPauseButton;
     QPushButton *nextButton;
     QPushButton *previousButton;
-    QSlider *positionSlider;
+    WaveformSlider *positionSlider;
     QLabel *nowPlayingLabel;
     QLabel *timeLabel;
-    bool wasPlaying;
 
     // Mini player widgets
     QWidget *miniPlayer;
@@ -76,7 +107,7 @@ private:
     QLabel *miniTitleLabel;
     QLabel *miniArtistLabel;
 
-    // Fullscreen player widgets
+    // Fullscreen player widgets, null until finishStartup()
     QWidget *fullscreenPlayer;
     QLabel *fullscreenAlbumArt;
     QLabel *fullscreenTitleLabel;
@@ -84,7 +115,7 @@ private:
     QPushButton *fullscreenPlayPauseButton;
     QPushButton *fullscreenNextButton;
     QPushButton *fullscreenPreviousButton;
-    QSlider *fullscreenProgressSlider;
+    WaveformSlider *fullscreenProgressSlider;
     QLabel *fullscreenTimeLabel;
     QLabel *fullscreenDurationLabel;
     QLabel *albumArtLabel;
@@ -98,15 +129,22 @@ private:
     QWidget *sidebar;
     QToolButton *menuButton;
     QStackedWidget *pages;
+    QLineEdit *searchBox;
     QList<QPushButton*> navButtons;
     QWidget *tracksPage;
     QWidget *albumsPage;
     QWidget *artistsPage;
     QWidget *playlistsPage;
-    QListWidget *tracksList;
-    QListWidget *albumsList;
-    QListWidget *artistsList;
-    QListWidget *playlistsList;
+    QListView *tracksList;
+    AlbumGridView *albumsList;
+    QToolButton *albumsGridButton;
+    QListView *artistsList;
+    QListView *artistAlbumsList;
+    QListView *playlistsList;
+    AlbumListModel *albumModel;
+    TrackListModel *trackModel;
+    ArtistListModel *artistModel;
+    AlbumListModel *artistAlbumModel;   // albums of the selected artist
     bool sidebarVisible;
     QSize originalWindowSize;  // Store the original window size
 };
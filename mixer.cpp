@@ -0,0 +1,108 @@
+#include "mixer.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIXER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MIXER_NEON
+#endif
+
+#if defined(MIXER_SSE2) || defined(MIXER_NEON)
+#define MIXER_SIMD
+#endif
+
+namespace {
+#if defined(MIXER_SSE2)
+    using Vector = __m128;
+    inline Vector load(const float *p) { return _mm_loadu_ps(p); }
+    inline void store(float *p, Vector v) { _mm_storeu_ps(p, v); }
+    inline Vector splat(float x) { return _mm_set1_ps(x); }
+    inline Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+    inline Vector mul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+    inline Vector make(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+#elif defined(MIXER_NEON)
+    using Vector = float32x4_t;
+    inline Vector load(const float *p) { return vld1q_f32(p); }
+    inline void store(float *p, Vector v) { vst1q_f32(p, v); }
+    inline Vector splat(float x) { return vdupq_n_f32(x); }
+    inline Vector add(Vector a, Vector b) { return vaddq_f32(a, b); }
+    inline Vector mul(Vector a, Vector b) { return vmulq_f32(a, b); }
+    inline Vector make(float a, float b, float c, float d)
+    {
+        const float values[4] = { a, b, c, d };
+        return vld1q_f32(values);
+    }
+#endif
+
+#ifdef MIXER_SIMD
+    constexpr qsizetype LANES = 4;
+#endif
+
+    constexpr float HALF_PI = 1.57079632679f;
+}
+
+void Mixer::scale(float *samples, qsizetype count, float gain)
+{
+    qsizetype i = 0;
+#ifdef MIXER_SIMD
+    const Vector g = splat(gain);
+    for (; i + 2 * LANES <= count; i += 2 * LANES) {
+        store(samples + i, mul(load(samples + i), g));
+        store(samples + i + LANES, mul(load(samples + i + LANES), g));
+    }
+    for (; i + LANES <= count; i += LANES) {
+        store(samples + i, mul(load(samples + i), g));
+    }
+#endif
+    for (; i < count; ++i) {
+        samples[i] *= gain;
+    }
+}
+
+void Mixer::crossfade(float *out, const float *in, qsizetype frames, int channels,
+                      float outGain, float outStep, float inGain, float inStep)
+{
+    qsizetype frame = 0;
+#ifdef MIXER_SIMD
+    if (channels == 1 || channels == 2) {
+        // Which frame of the vector each lane belongs to
+        const Vector lanes = channels == 1 ? make(0, 1, 2, 3) : make(0, 0, 1, 1);
+        const float framesPerVector = float(LANES / channels);
+        Vector gOut = add(splat(outGain), mul(lanes, splat(outStep)));
+        Vector gIn = add(splat(inGain), mul(lanes, splat(inStep)));
+        const Vector dOut = splat(outStep * framesPerVector);
+        const Vector dIn = splat(inStep * framesPerVector);
+
+        const qsizetype count = frames * channels;
+        qsizetype i = 0;
+        for (; i + LANES <= count; i += LANES) {
+            store(out + i, add(mul(load(out + i), gOut), mul(load(in + i), gIn)));
+            gOut = add(gOut, dOut);
+            gIn = add(gIn, dIn);
+        }
+        frame = i / channels;
+    }
+#endif
+    for (; frame < frames; ++frame) {
+        const float o = outGain + float(frame) * outStep;
+        const float n = inGain + float(frame) * inStep;
+        for (int c = 0; c < channels; ++c) {
+            const qsizetype i = frame * channels + c;
+            out[i] = out[i] * o + in[i] * n;
+        }
+    }
+}
+
+float Mixer::fadeOutGain(CrossfadeCurve curve, float t)
+{
+    t = std::fmin(std::fmax(t, 0.0f), 1.0f);
+    return curve == CrossfadeCurve::Linear ? 1.0f - t : std::cos(t * HALF_PI);
+}
+
+float Mixer::fadeInGain(CrossfadeCurve curve, float t)
+{
+    t = std::fmin(std::fmax(t, 0.0f), 1.0f);
+    return curve == CrossfadeCurve::Linear ? t : std::sin(t * HALF_PI);
+}
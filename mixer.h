@@ -0,0 +1,25 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <QtGlobal>
+#include "common.h"
+
+// Gain and mixing kernels over interleaved float samples, used from the
+// audio callback: no allocation, no locks. The loops are vectorized with
+// SSE2 or NEON where available, for mono and stereo; other layouts and
+// the tails fall back to scalar code.
+namespace Mixer {
+    // samples *= gain
+    void scale(float *samples, qsizetype count, float gain);
+
+    // out = out * outGain + in * inGain, per frame, with both gains moving
+    // linearly by their step from one frame to the next
+    void crossfade(float *out, const float *in, qsizetype frames, int channels,
+                   float outGain, float outStep, float inGain, float inStep);
+
+    // Gains of the outgoing and incoming stream at t in [0, 1] of a fade
+    float fadeOutGain(CrossfadeCurve curve, float t);
+    float fadeInGain(CrossfadeCurve curve, float t);
+}
+
+#endif // MIXER_H
@@ -1,34 +1,58 @@
 #include "musiclibrary.h"
+#include "audiofiletype.h"
+#include "logging.h"
+#include "trace.h"
 #include <QStandardPaths>
 #include <QDirIterator>
 #include <QDebug>
-#include <QMimeDatabase>
-#include <QMimeType>
 #include <QDir>
 #include <QFileInfo>
+#include <QDateTime>
+#include <QSet>
+
+namespace {
+    constexpr int SAVE_INTERVAL_MS = 30000;
+}
 
 MusicLibrary::MusicLibrary(QObject *parent)
     : QObject(parent)
     , m_isLoading(false)
-    , m_watcher(new QFileSystemWatcher(this))
+    , m_pruneAfterScan(false)
+    , m_scanner(new DirectoryScanner(this))
+    , m_tagExtractor(new TagExtractor(this))
+    , m_analyzer(new LoudnessAnalyzer(this))
+    , m_store(new TrackStore(this))
+    , m_search(new SearchIndex(m_store, this))
+    , m_watcher(new LibraryWatcher(this))
 {
-    // Add supported MIME types for audio files
-    m_supportedFormats << "audio/mpeg"      // MP3
-                      << "audio/mp4"        // M4A
-                      << "audio/ogg"        // OGG
-                      << "audio/flac"       // FLAC
-                      << "audio/wav"        // WAV
-                      << "audio/x-wav"      // WAV (alternative MIME type)
-                      << "audio/x-flac";    // FLAC (alternative MIME type)
+    m_scanner->setFilter(&AudioFileType::isAudioFile);
+    connect(m_scanner, &DirectoryScanner::filesFound, this, &MusicLibrary::onFilesFound);
+    connect(m_scanner, &DirectoryScanner::progressChanged, this, &MusicLibrary::scanProgressChanged);
+    connect(m_scanner, &DirectoryScanner::finished, this, &MusicLibrary::onScanFinished);
+    connect(m_scanner, &DirectoryScanner::directoriesFound, m_watcher, &LibraryWatcher::addDirectories);
+    connect(m_tagExtractor, &TagExtractor::tracksRead, this, &MusicLibrary::onTracksRead);
+    connect(m_tagExtractor, &TagExtractor::idle, this, &MusicLibrary::updateLoadingState);
+    connect(m_watcher, &LibraryWatcher::directoriesChanged, this, &MusicLibrary::onDirectoriesChanged);
+    connect(m_analyzer, &LoudnessAnalyzer::albumMeasured, this, &MusicLibrary::onAlbumMeasured);
+
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(SAVE_INTERVAL_MS);
+    connect(&m_saveTimer, &QTimer::timeout, this, [this]() {
+        // A running scan saves when it is done
+        if (!m_isLoading && m_index.isDirty()) {
+            m_index.save(*m_store);
+        }
+    });
 }
 
 MusicLibrary::~MusicLibrary()
 {
 }
 
+// Built on demand from the store; the list pages use the models instead
 QStringList MusicLibrary::audioFiles() const
 {
-    return m_audioFiles;
+    return m_store->filePaths();
 }
 
 bool MusicLibrary::isLoading() const
@@ -36,37 +60,334 @@ bool MusicLibrary::isLoading() const
     return m_isLoading;
 }
 
+void MusicLibrary::loadIndex()
+{
+    QList<TrackInfo> tracks;
+    if (!m_index.load(&tracks)) {
+        return;
+    }
+
+    qCDebug(lcLibrary) << "Loaded" << tracks.size() << "tracks from" << m_index.fileName();
+
+    // Show the cached library right away; the next scan reconciles it with disk
+    QStringList files;
+    files.reserve(tracks.size());
+    for (const TrackInfo &info : std::as_const(tracks)) {
+        files.append(info.filePath);
+    }
+    m_store->insert(tracks);
+    emit audioFilesAdded(files);
+    emit audioFilesChanged();
+}
+
+TrackInfo MusicLibrary::trackInfo(const QString &filePath) const
+{
+    const int id = m_store->trackId(filePath);
+    if (id >= 0) {
+        return m_store->track(id);
+    }
+    return TrackInfo::read(filePath);
+}
+
+TrackStore *MusicLibrary::trackStore() const
+{
+    return m_store;
+}
+
+SearchIndex *MusicLibrary::searchIndex() const
+{
+    return m_search;
+}
+
+int MusicLibrary::scannedDirectories() const
+{
+    return m_scanner->directoriesScanned();
+}
+
+int MusicLibrary::queuedDirectories() const
+{
+    return m_scanner->directoriesQueued();
+}
+
 void MusicLibrary::scanMusicDirectory()
 {
-    qDebug() << "Starting music directory scan...";
-    m_audioFiles.clear();
+    qCDebug(lcLibrary) << "Starting music directory scan...";
 
     // Get standard music locations
     QStringList musicDirs = QStandardPaths::standardLocations(QStandardPaths::MusicLocation);
-    qDebug() << "Music directories found:" << musicDirs;
+    qCDebug(lcLibrary) << "Music directories found:" << musicDirs;
+
+    startScan(musicDirs, true);
+}
 
-    // Scan each directory
-    for (const QString &dir : musicDirs) {
-        addDirectory(dir);
+void MusicLibrary::addDirectory(const QString& path)
+{
+    if (m_scanner->isRunning()) {
+        m_scanner->add(QStringList() << path);
+    } else {
+        startScan(QStringList() << path, false);
     }
+}
 
-    // Emit signal with updated files
-    emit audioFilesChanged(m_audioFiles);
+void MusicLibrary::cancelScan()
+{
+    m_tagExtractor->cancel();
+    m_pendingTags.clear();
+    m_scanner->cancel();
 }
 
-void MusicLibrary::addDirectory(const QString& path)
+void MusicLibrary::startScan(const QStringList &roots, bool pruneMissing)
+{
+    // Decode errors may have been passing ones, so a scan tries again
+    m_loudnessFailed.clear();
+    m_scanSeen = QBitArray(m_store->idLimit());
+    m_pruneAfterScan = pruneMissing;
+    m_scanner->start(roots);
+    updateLoadingState();
+    emit scanProgressChanged();
+}
+
+void MusicLibrary::onFilesFound(const QFileInfoList &files)
+{
+    QStringList stale;
+
+    for (const QFileInfo &entry : files) {
+        qCDebug(lcScan) << "Found audio file:" << entry.filePath();
+        handleFoundFile(entry, &stale);
+    }
+
+    m_tagExtractor->enqueue(stale);
+}
+
+void MusicLibrary::onTracksRead(const QList<TrackInfo> &tracks)
 {
-    QDir dir(path);
-    QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    QList<TrackInfo> read;
+    QStringList added;
+    QStringList updated;
+
+    for (const TrackInfo &info : tracks) {
+        // Dropped if the file was removed or the scan cancelled meanwhile
+        if (!m_pendingTags.remove(info.filePath)) {
+            continue;
+        }
 
-    for (const QFileInfo &entry : entries) {
-        if (entry.isDir()) {
-            addDirectory(entry.filePath());
-        } else if (isAudioFile(entry.filePath())) {
-            qDebug() << "Found audio file:" << entry.filePath();
-            m_audioFiles.append(entry.filePath());
+        read.append(info);
+        if (m_store->trackId(info.filePath) < 0) {
+            added.append(info.filePath);
+        } else {
+            updated.append(info.filePath);
         }
     }
+    if (read.isEmpty()) {
+        return;
+    }
+
+    m_store->insert(read);
+    m_index.setDirty();
+    for (const QString &filePath : std::as_const(added)) {
+        markSeen(m_store->trackId(filePath));
+    }
+
+    if (!added.isEmpty()) {
+        emit audioFilesAdded(added);
+    }
+    if (!updated.isEmpty()) {
+        emit audioFilesUpdated(updated);
+    }
+}
+
+void MusicLibrary::onAlbumMeasured(const QList<TrackInfo> &tracks)
+{
+    bool changed = false;
+    for (const TrackInfo &info : tracks) {
+        // Dropped if the file was removed or changed while it was measured
+        const int id = m_store->trackId(info.filePath);
+        if (!info.loudness.track.isValid()) {
+            m_loudnessFailed.insert(info.filePath);
+        } else if (id >= 0 && m_store->matches(id, info.size, info.modified)) {
+            m_store->setLoudness(id, info.loudness);
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        m_index.setDirty();
+        if (!m_saveTimer.isActive()) {
+            m_saveTimer.start();
+        }
+    }
+}
+
+void MusicLibrary::analyzeLoudness()
+{
+    // An album is measured as a whole, so a single track without an album
+    // value (a new one, say) queues all of its tracks again
+    QSet<int> albums;
+    for (int id = 0; id < m_store->idLimit(); ++id) {
+        if (!m_store->contains(id) || m_store->loudness(id).album.isValid()
+                || m_loudnessFailed.contains(m_store->filePath(id))) {
+            continue;
+        }
+
+        const int albumId = m_store->trackAlbum(id);
+        if (albumId < 0) {
+            m_analyzer->enqueue(QList<TrackInfo>() << m_store->track(id));
+        } else if (!albums.contains(albumId)) {
+            albums.insert(albumId);
+            QList<TrackInfo> tracks;
+            for (int track : m_store->albumTracks(albumId)) {
+                tracks.append(m_store->track(track));
+            }
+            m_analyzer->enqueue(tracks);
+        }
+    }
+}
+
+void MusicLibrary::onScanFinished(bool cancelled)
+{
+    if (!cancelled && m_pruneAfterScan) {
+        // Anything the scan did not see has been deleted or moved
+        QStringList removed;
+        for (int id = 0; id < m_scanSeen.size(); ++id) {
+            if (m_store->contains(id) && !m_scanSeen.testBit(id)) {
+                removed.append(m_store->filePath(id));
+            }
+        }
+
+        removeFiles(removed);
+    }
+    m_scanSeen.clear();
+
+    qCDebug(lcLibrary) << "Music directory scan" << (cancelled ? "cancelled" : "finished")
+                       << "with" << m_store->trackCount() << "tracks";
+
+    updateLoadingState();
+}
+
+void MusicLibrary::updateLoadingState()
+{
+    const bool loading = m_scanner->isRunning() || m_tagExtractor->isBusy();
+    if (loading == m_isLoading) {
+        return;
+    }
+
+    if (!loading) {
+        if (m_index.isDirty()) {
+            m_index.save(*m_store);
+        }
+        emit audioFilesChanged();
+        analyzeLoudness();
+    }
+    setIsLoading(loading);
+}
+
+void MusicLibrary::removeFiles(const QStringList &files)
+{
+    if (files.isEmpty()) {
+        return;
+    }
+
+    for (const QString &filePath : files) {
+        m_pendingTags.remove(filePath);
+    }
+    m_store->remove(files);
+    m_index.setDirty();
+    emit audioFilesRemoved(files);
+}
+
+void MusicLibrary::markSeen(int id)
+{
+    if (id >= 0 && id < m_scanSeen.size()) {
+        m_scanSeen.setBit(id);
+    }
+}
+
+void MusicLibrary::handleFoundFile(const QFileInfo &entry, QStringList *stale)
+{
+    const QString filePath = entry.filePath();
+    const qint64 modified = entry.lastModified().toMSecsSinceEpoch();
+    const int id = m_store->trackId(filePath);
+    markSeen(id);
+
+    if (id < 0 || !m_store->matches(id, entry.size(), modified)) {
+        // New or changed on disk, so this is the only time TagLib opens it
+        if (!m_pendingTags.contains(filePath)) {
+            m_pendingTags.insert(filePath);
+            stale->append(filePath);
+        }
+    }
+}
+
+void MusicLibrary::onDirectoriesChanged(const QStringList &dirs)
+{
+    TRACE_SCOPE("rescan directories");
+    QSet<QString> present;
+    QStringList goneDirs;
+    QStringList newDirs;
+    QStringList stale;
+
+    // Only the changed directories are listed; their subtrees are untouched
+    // unless a subdirectory appeared or disappeared
+    for (const QString &dir : dirs) {
+        if (!QFileInfo::exists(dir)) {
+            goneDirs.append(dir);
+            continue;
+        }
+
+        QDirIterator it(dir, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+        while (it.hasNext()) {
+            it.next();
+            const QFileInfo entry = it.fileInfo();
+            const QString filePath = entry.filePath();
+            if (entry.isDir()) {
+                if (!m_watcher->contains(filePath)) {
+                    newDirs.append(filePath);
+                }
+            } else if (AudioFileType::isAudioFile(entry)) {
+                present.insert(filePath);
+                handleFoundFile(entry, &stale);
+            }
+        }
+    }
+
+    QStringList removed;
+    for (const QString &dir : dirs) {
+        const bool gone = goneDirs.contains(dir);
+        const QVector<int> ids = m_store->tracksInDirectory(dir, gone);
+        for (int id : ids) {
+            const QString filePath = m_store->filePath(id);
+            if (gone || !present.contains(filePath)) {
+                removed.append(filePath);
+            }
+        }
+    }
+
+    for (const QString &dir : std::as_const(goneDirs)) {
+        m_watcher->removeDirectories(dir);
+    }
+
+    removeFiles(removed);
+    m_tagExtractor->enqueue(stale);
+
+    // New subdirectories are walked in full by the scanner
+    if (!newDirs.isEmpty()) {
+        if (m_scanner->isRunning()) {
+            m_scanner->add(newDirs);
+        } else {
+            startScan(newDirs, false);
+        }
+    }
+
+    updateLoadingState();
+    if (!m_isLoading) {
+        if (m_index.isDirty()) {
+            m_index.save(*m_store);
+        }
+        if (!removed.isEmpty()) {
+            emit audioFilesChanged();
+        }
+        analyzeLoudness();
+    }
 }
 
 QString MusicLibrary::getFileName(const QString& filePath) const
@@ -80,14 +401,6 @@ QString MusicLibrary::getFileExtension(const QString &filePath) const
     return fileInfo.suffix().toLower();
 }
 
-void MusicLibrary::setAudioFiles(const QStringList& files)
-{
-    if (m_audioFiles != files) {
-        m_audioFiles = files;
-        emit audioFilesChanged(m_audioFiles);
-    }
-}
-
 void MusicLibrary::setIsLoading(bool loading)
 {
     if (m_isLoading != loading) {
@@ -96,20 +409,3 @@ void MusicLibrary::setIsLoading(bool loading)
     }
 }
 
-bool MusicLibrary::isAudioFile(const QString& filePath) const
-{
-    QMimeDatabase db;
-    QMimeType mime = db.mimeTypeForFile(filePath);
-    QString extension = QFileInfo(filePath).suffix().toLower();
-    
-    qDebug() << "Checking file:" << filePath;
-    qDebug() << "MIME type:" << mime.name();
-    qDebug() << "Extension:" << extension;
-
-    // List of supported audio file extensions
-    static const QStringList supportedExtensions = {
-        "mp3", "m4a", "aac", "ogg", "wav", "flac", "wma"
-    };
-
-    return mime.name().startsWith("audio/") || supportedExtensions.contains(extension);
-} 
\ No newline at end of file
@@ -6,16 +6,25 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QStandardPaths>
-#include <QMimeDatabase>
-#include <QMimeType>
 #include <QDebug>
-#include <QFileSystemWatcher>
+#include <QSet>
+#include <QBitArray>
+#include <QTimer>
+#include "libraryindex.h"
+#include "directoryscanner.h"
+#include "librarywatcher.h"
+#include "tagextractor.h"
+#include "loudnessanalyzer.h"
+#include "trackstore.h"
+#include "searchindex.h"
 
 class MusicLibrary : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QStringList audioFiles READ audioFiles NOTIFY audioFilesChanged)
     Q_PROPERTY(bool isLoading READ isLoading NOTIFY isLoadingChanged)
+    Q_PROPERTY(int scannedDirectories READ scannedDirectories NOTIFY scanProgressChanged)
+    Q_PROPERTY(int queuedDirectories READ queuedDirectories NOTIFY scanProgressChanged)
 
 public:
     explicit MusicLibrary(QObject *parent = nullptr);
@@ -23,29 +32,59 @@ public:
 
     QStringList audioFiles() const;
     bool isLoading() const;
+    int scannedDirectories() const;
+    int queuedDirectories() const;
 
     Q_INVOKABLE void scanMusicDirectory();
+    Q_INVOKABLE void cancelScan();
+    void loadIndex();
+    TrackInfo trackInfo(const QString &filePath) const;
+    TrackStore *trackStore() const;
+    SearchIndex *searchIndex() const;
     Q_INVOKABLE QString getFileName(const QString &filePath) const;
     Q_INVOKABLE QString getFileExtension(const QString &filePath) const;
 
     void addDirectory(const QString& path);
 
-    void setAudioFiles(const QStringList& files);
-
 signals:
-    void audioFilesChanged(const QStringList& files);
+    void audioFilesChanged();
+    void audioFilesAdded(const QStringList& files);
+    void audioFilesRemoved(const QStringList& files);
+    void audioFilesUpdated(const QStringList& files);
     void isLoadingChanged();
+    void scanProgressChanged();
+
+private slots:
+    void onFilesFound(const QFileInfoList &files);
+    void onScanFinished(bool cancelled);
+    void onDirectoriesChanged(const QStringList &dirs);
+    void onTracksRead(const QList<TrackInfo> &tracks);
+    void onAlbumMeasured(const QList<TrackInfo> &tracks);
+    void updateLoadingState();
 
 private:
-    QStringList m_audioFiles;
     bool m_isLoading;
-    QStringList m_supportedFormats;
     
     void setIsLoading(bool loading);
-    void scanDirectory(const QString &path);
-    bool isAudioFile(const QString &filePath) const;
+    void startScan(const QStringList &roots, bool pruneMissing);
+    void handleFoundFile(const QFileInfo &entry, QStringList *stale);
+    void removeFiles(const QStringList &files);
+    void markSeen(int id);
+    void analyzeLoudness();
+
+    LibraryIndex m_index;
+    QBitArray m_scanSeen;   // by track id; ids past the end count as seen
+    QSet<QString> m_pendingTags;
+    QSet<QString> m_loudnessFailed; // not measured again until the next scan
+    bool m_pruneAfterScan;
+    DirectoryScanner *m_scanner;
+    TagExtractor *m_tagExtractor;
+    LoudnessAnalyzer *m_analyzer;
+    QTimer m_saveTimer;         // saves loudness results now and then
+    TrackStore *m_store;
+    SearchIndex *m_search;
 
-    QFileSystemWatcher* m_watcher;
+    LibraryWatcher* m_watcher;
 };
 
 #endif // MUSICLIBRARY_H 
\ No newline at end of file
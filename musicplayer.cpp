@@ -1,15 +1,15 @@
 #include "musicplayer.h"
-#include <QMediaMetaData>
+#include "playbackcore.h"
+#include "coverstore.h"
+#include <QFileInfo>
 
-MusicPlayer::MusicPlayer(QObject *parent)
+MusicPlayer::MusicPlayer(PlaybackCore *core, QObject *parent)
     : QObject(parent)
-    , m_player(new QMediaPlayer(this))
-    , m_audioOutput(new QAudioOutput(this))
+    , m_core(core)
+    , m_player(core->player())
 {
-    m_player->setAudioOutput(m_audioOutput);
-    
     // Connect player signals
-    connect(m_player, &QMediaPlayer::playbackStateChanged,
+    connect(m_player, &PlaybackBackend::playbackStateChanged,
             this, [this](QMediaPlayer::PlaybackState state) {
                 switch (state) {
                     case QMediaPlayer::PlaybackState::PlayingState:
@@ -24,53 +24,50 @@ MusicPlayer::MusicPlayer(QObject *parent)
                 }
             });
 
-    connect(m_player, &QMediaPlayer::positionChanged,
+    connect(m_player, &PlaybackBackend::positionChanged,
             this, &MusicPlayer::positionChanged);
     
-    connect(m_player, &QMediaPlayer::durationChanged,
+    connect(m_player, &PlaybackBackend::durationChanged,
             this, &MusicPlayer::durationChanged);
 
-    connect(m_player, &QMediaPlayer::errorOccurred,
+    connect(m_player, &PlaybackBackend::currentIndexChanged,
+            this, &MusicPlayer::currentIndexChanged);
+
+    connect(m_player, &PlaybackBackend::errorOccurred,
             this, [this](QMediaPlayer::Error error, const QString &errorString) {
                 emit this->error(errorString);
             });
 
-    connect(m_player, &QMediaPlayer::metaDataChanged,
-            this, [this]() {
-                const QMediaMetaData metaData = m_player->metaData();
-                
-                QString title = metaData.stringValue(QMediaMetaData::Title);
-                if (!title.isEmpty() && title != m_currentSong) {
-                    m_currentSong = title;
-                    emit currentSongChanged();
-                }
+    // What is playing comes from the core, which reads it once per entry
+    connect(m_core, &PlaybackCore::nowPlayingChanged, this, &MusicPlayer::updateNowPlaying);
+    updateNowPlaying();
+}
 
-                QString artist = metaData.stringValue(QMediaMetaData::AlbumArtist);
-                if (artist.isEmpty()) {
-                    artist = metaData.stringValue(QMediaMetaData::ContributingArtist);
-                }
-                if (!artist.isEmpty() && artist != m_currentArtist) {
-                    m_currentArtist = artist;
-                    emit currentArtistChanged();
-                }
+void MusicPlayer::updateNowPlaying()
+{
+    const TrackInfo &info = m_core->nowPlaying();
 
-                QUrl artwork = metaData.value(QMediaMetaData::ThumbnailImage).toUrl();
-                if (artwork.isEmpty()) {
-                    artwork = metaData.value(QMediaMetaData::CoverArtImage).toUrl();
-                }
-                if (!artwork.isEmpty() && artwork != m_currentArtwork) {
-                    m_currentArtwork = artwork;
-                    emit currentArtworkChanged();
-                }
-            });
+    QString song = info.title;
+    if (song.isEmpty() && !info.filePath.isEmpty()) {
+        song = QFileInfo(info.filePath).completeBaseName();
+    }
+    if (song != m_currentSong) {
+        m_currentSong = song;
+        emit currentSongChanged();
+    }
 
-    // Set initial volume
-    m_audioOutput->setVolume(0.5); // 50%
-}
+    const QString artist = !info.albumArtist.isEmpty() ? info.albumArtist : info.artist;
+    if (artist != m_currentArtist) {
+        m_currentArtist = artist;
+        emit currentArtistChanged();
+    }
 
-MusicPlayer::~MusicPlayer()
-{
-    stop();
+    const QString artKey = info.artKey();
+    const QUrl artwork = artKey.isEmpty() ? QUrl() : QUrl::fromLocalFile(CoverStore::masterFile(artKey));
+    if (artwork != m_currentArtwork) {
+        m_currentArtwork = artwork;
+        emit currentArtworkChanged();
+    }
 }
 
 PlaybackState MusicPlayer::state() const
@@ -97,7 +94,7 @@ qint64 MusicPlayer::duration() const
 
 int MusicPlayer::volume() const
 {
-    return static_cast<int>(m_audioOutput->volume() * 100);
+    return static_cast<int>(m_player->volume() * 100);
 }
 
 void MusicPlayer::play()
@@ -122,11 +119,54 @@ void MusicPlayer::seek(qint64 position)
 
 void MusicPlayer::setSource(const QUrl &url)
 {
-    m_player->setSource(url);
+    m_core->setQueue({ url });
 }
 
 void MusicPlayer::setVolume(int volume)
 {
-    m_audioOutput->setVolume(volume / 100.0);
+    m_player->setVolume(volume / 100.0);
     emit volumeChanged(volume);
-} 
\ No newline at end of file
+}
+
+int MusicPlayer::crossfade() const
+{
+    return canCrossfade() ? m_player->crossfadeDuration() : 0;
+}
+
+bool MusicPlayer::canCrossfade() const
+{
+    return m_player->canCrossfade();
+}
+
+void MusicPlayer::setCrossfade(int msecs)
+{
+    if (canCrossfade() && msecs != m_player->crossfadeDuration()) {
+        m_player->setCrossfade(msecs, m_player->crossfadeCurve());
+        emit crossfadeChanged(m_player->crossfadeDuration());
+    }
+}
+
+int MusicPlayer::currentIndex() const
+{
+    return m_player->currentIndex();
+}
+
+void MusicPlayer::setQueue(const QList<QUrl> &urls, int index)
+{
+    m_core->setQueue(urls, index);
+}
+
+void MusicPlayer::setCurrentIndex(int index)
+{
+    m_player->setCurrentIndex(index);
+}
+
+void MusicPlayer::next()
+{
+    m_player->next();
+}
+
+void MusicPlayer::previous()
+{
+    m_player->previous();
+}
@@ -3,10 +3,12 @@
 
 #include <QObject>
 #include <QUrl>
-#include <QMediaPlayer>
-#include <QAudioOutput>
+#include "playbackbackend.h"
 #include "common.h"
 
+class PlaybackCore;
+
+// The QML front end's view of the shared PlaybackCore
 class MusicPlayer : public QObject
 {
     Q_OBJECT
@@ -17,10 +19,13 @@ class MusicPlayer : public QObject
     Q_PROPERTY(qint64 position READ position NOTIFY positionChanged)
     Q_PROPERTY(qint64 duration READ duration NOTIFY durationChanged)
     Q_PROPERTY(int volume READ volume WRITE setVolume NOTIFY volumeChanged)
+    // Always 0 unless canCrossfade; QMediaPlayer decks cannot overlap
+    Q_PROPERTY(int crossfade READ crossfade WRITE setCrossfade NOTIFY crossfadeChanged)
+    Q_PROPERTY(bool canCrossfade READ canCrossfade CONSTANT)
+    Q_PROPERTY(int currentIndex READ currentIndex WRITE setCurrentIndex NOTIFY currentIndexChanged)
 
 public:
-    explicit MusicPlayer(QObject *parent = nullptr);
-    ~MusicPlayer();
+    explicit MusicPlayer(PlaybackCore *core, QObject *parent = nullptr);
 
     QString currentSong() const { return m_currentSong; }
     QString currentArtist() const { return m_currentArtist; }
@@ -29,6 +34,9 @@ public:
     qint64 position() const;
     qint64 duration() const;
     int volume() const;
+    int crossfade() const;
+    bool canCrossfade() const;
+    int currentIndex() const;
 
 public slots:
     void play();
@@ -37,6 +45,14 @@ public slots:
     void seek(qint64 position);
     void setSource(const QUrl &url);
     void setVolume(int volume);
+    // Overlap between queue entries in msecs; ignored without canCrossfade
+    void setCrossfade(int msecs);
+    // Queue entries play back to back without a gap, levelled by
+    // ReplayGain for the files in the library
+    void setQueue(const QList<QUrl> &urls, int index = 0);
+    void setCurrentIndex(int index);
+    void next();
+    void previous();
 
 signals:
     void currentSongChanged();
@@ -46,11 +62,15 @@ signals:
     void positionChanged(qint64 position);
     void durationChanged(qint64 duration);
     void volumeChanged(int volume);
+    void crossfadeChanged(int msecs);
+    void currentIndexChanged(int index);
     void error(const QString &message);
 
 private:
-    QMediaPlayer *m_player;
-    QAudioOutput *m_audioOutput;
+    void updateNowPlaying();
+
+    PlaybackCore *m_core;
+    PlaybackBackend *m_player;
     QString m_currentSong;
     QString m_currentArtist;
     QUrl m_currentArtwork;
@@ -0,0 +1,170 @@
+#include "playbackbackend.h"
+#include "gaplessplayer.h"
+#include "audioengine.h"
+#include "logging.h"
+#include "trace.h"
+#include <cmath>
+
+PlaybackBackend::PlaybackBackend(QObject *parent)
+    : QObject(parent)
+    , m_index(-1)
+    , m_crossfade(0)
+    , m_curve(CrossfadeCurve::EqualPower)
+    , m_replayGain(ReplayGainMode::Album)
+{
+}
+
+namespace {
+    constexpr int MAX_CROSSFADE = 12000;    // msecs
+    constexpr float REPLAYGAIN_REFERENCE = -18.0f;  // LUFS, as in ReplayGain 2.0
+}
+
+PlaybackBackend *PlaybackBackend::create(QObject *parent)
+{
+    // MUSE_CROSSFADE=<secs>[,linear|,equalpower]
+    const QStringList crossfade = qEnvironmentVariable("MUSE_CROSSFADE").split(QLatin1Char(','));
+    const int msecs = qRound(crossfade.first().toDouble() * 1000);
+    const CrossfadeCurve curve = crossfade.value(1).trimmed() == QLatin1String("linear")
+                                 ? CrossfadeCurve::Linear : CrossfadeCurve::EqualPower;
+
+    PlaybackBackend *backend;
+    if (msecs > 0 || qEnvironmentVariable("MUSE_AUDIO_ENGINE") == QLatin1String("native")) {
+        qCInfo(lcPlayback) << "Using the native audio engine";
+        backend = new AudioEngine(parent);
+    } else {
+        backend = new GaplessPlayer(parent);
+    }
+    if (msecs > 0) {
+        backend->setCrossfade(msecs, curve);
+    }
+
+    const QString replayGain = qEnvironmentVariable("MUSE_REPLAYGAIN");
+    if (replayGain == QLatin1String("off")) {
+        backend->setReplayGainMode(ReplayGainMode::Off);
+    } else if (replayGain == QLatin1String("track")) {
+        backend->setReplayGainMode(ReplayGainMode::Track);
+    }
+    return backend;
+}
+
+int PlaybackBackend::crossfadeDuration() const
+{
+    return m_crossfade;
+}
+
+CrossfadeCurve PlaybackBackend::crossfadeCurve() const
+{
+    return m_curve;
+}
+
+void PlaybackBackend::setCrossfade(int msecs, CrossfadeCurve curve)
+{
+    m_crossfade = qBound(0, msecs, MAX_CROSSFADE);
+    m_curve = curve;
+}
+
+ReplayGainMode PlaybackBackend::replayGainMode() const
+{
+    return m_replayGain;
+}
+
+void PlaybackBackend::setReplayGainMode(ReplayGainMode mode)
+{
+    m_replayGain = mode;
+}
+
+float PlaybackBackend::replayGain(int index) const
+{
+    if (m_replayGain == ReplayGainMode::Off || index < 0 || index >= m_loudness.size()) {
+        return 1.0f;
+    }
+
+    const LoudnessInfo &info = m_loudness.at(index);
+    const Loudness &loudness = m_replayGain == ReplayGainMode::Album && info.album.isValid()
+                               ? info.album : info.track;
+    if (!loudness.isValid() || !std::isfinite(loudness.integrated)) {
+        return 1.0f;
+    }
+
+    float gain = std::pow(10.0f, (REPLAYGAIN_REFERENCE - loudness.integrated) / 20.0f);
+    if (loudness.truePeak > 0.0f) {
+        gain = qMin(gain, 1.0f / loudness.truePeak);
+    }
+    return gain;
+}
+
+void PlaybackBackend::setQueue(const QList<QUrl> &queue, int index, const QList<LoudnessInfo> &loudness)
+{
+    m_queue = queue;
+    m_loudness = loudness.size() == queue.size() ? loudness : QList<LoudnessInfo>();
+    changeEntry(index >= 0 && index < m_queue.size() ? index : -1, false);
+}
+
+const QList<QUrl> &PlaybackBackend::queue() const
+{
+    return m_queue;
+}
+
+int PlaybackBackend::currentIndex() const
+{
+    return m_index;
+}
+
+bool PlaybackBackend::hasNext() const
+{
+    return m_index >= 0 && m_index + 1 < m_queue.size();
+}
+
+bool PlaybackBackend::hasPrevious() const
+{
+    return m_index > 0;
+}
+
+QUrl PlaybackBackend::source() const
+{
+    return m_queue.value(m_index);
+}
+
+void PlaybackBackend::setSource(const QUrl &url)
+{
+    setQueue(url.isEmpty() ? QList<QUrl>() : QList<QUrl>{ url });
+}
+
+void PlaybackBackend::setCurrentIndex(int index)
+{
+    if (index >= 0 && index < m_queue.size() && index != m_index) {
+        changeEntry(index, playbackState() == QMediaPlayer::PlayingState);
+    }
+}
+
+void PlaybackBackend::next()
+{
+    if (hasNext()) {
+        changeEntry(m_index + 1, playbackState() == QMediaPlayer::PlayingState);
+    }
+}
+
+void PlaybackBackend::previous()
+{
+    if (hasPrevious()) {
+        changeEntry(m_index - 1, playbackState() == QMediaPlayer::PlayingState);
+    }
+}
+
+void PlaybackBackend::changeEntry(int index, bool play)
+{
+    TRACE_SCOPE("change entry");
+    m_index = index;
+    load(index, play);
+    emit currentIndexChanged(m_index);
+    emit sourceChanged(source());
+}
+
+void PlaybackBackend::setCurrentEntry(int index)
+{
+    if (index != m_index) {
+        m_index = index;
+        emit currentIndexChanged(m_index);
+        emit sourceChanged(source());
+    }
+}
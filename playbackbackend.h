@@ -0,0 +1,98 @@
+#ifndef PLAYBACKBACKEND_H
+#define PLAYBACKBACKEND_H
+
+#include <QObject>
+#include <QList>
+#include <QUrl>
+#include <QMediaPlayer>
+#include <QMediaMetaData>
+#include "common.h"
+#include "trackinfo.h"
+
+// What the front ends play through: a queue of files plus the parts of
+// the QMediaPlayer API they use. The queue lives here; a backend only
+// has to load an entry and report back when it moves on by itself.
+//
+// create() picks the backend: GaplessPlayer on top of QMediaPlayer by
+// default, or our own AudioEngine with MUSE_AUDIO_ENGINE=native.
+// MUSE_CROSSFADE=<secs>[,linear] sets a crossfade, which only the
+// native engine can mix, so it picks that one too.
+// MUSE_REPLAYGAIN=off|track|album picks how entries are leveled; album
+// is the default, falling back to track gain where no album value is known.
+class PlaybackBackend : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlaybackBackend(QObject *parent = nullptr);
+
+    static PlaybackBackend *create(QObject *parent = nullptr);
+
+    // Replaces the queue and makes index the current entry; loudness, if
+    // given, has one entry per queue entry
+    void setQueue(const QList<QUrl> &queue, int index = 0, const QList<LoudnessInfo> &loudness = {});
+    const QList<QUrl> &queue() const;
+    int currentIndex() const;
+    bool hasNext() const;
+    bool hasPrevious() const;
+    QUrl source() const;
+
+    virtual QMediaPlayer::PlaybackState playbackState() const = 0;
+    virtual qint64 position() const = 0;
+    virtual qint64 duration() const = 0;
+    // What the decoder read itself; empty if it reads no tags
+    virtual QMediaMetaData metaData() const = 0;
+    virtual float volume() const = 0;
+    // Whether entries can overlap at all; the crossfade is ignored if not
+    virtual bool canCrossfade() const { return false; }
+    int crossfadeDuration() const;
+    CrossfadeCurve crossfadeCurve() const;
+    ReplayGainMode replayGainMode() const;
+
+public slots:
+    virtual void play() = 0;
+    virtual void pause() = 0;
+    virtual void stop() = 0;
+    virtual void setPosition(qint64 position) = 0;
+    virtual void setVolume(float volume) = 0;
+    // Overlap between consecutive entries, in msecs; 0 plays them back to
+    // back. Ignored by backends that cannot mix two entries
+    virtual void setCrossfade(int msecs, CrossfadeCurve curve);
+    // Levels entries by their measured loudness, as set with the queue
+    virtual void setReplayGainMode(ReplayGainMode mode);
+    // Plays a single file, as a one-entry queue
+    void setSource(const QUrl &url);
+    void setCurrentIndex(int index);
+    void next();
+    void previous();
+
+signals:
+    void currentIndexChanged(int index);
+    void sourceChanged(const QUrl &source);
+    void playbackStateChanged(QMediaPlayer::PlaybackState state);
+    void positionChanged(qint64 position);
+    void durationChanged(qint64 duration);
+    void metaDataChanged();
+    void errorOccurred(QMediaPlayer::Error error, const QString &errorString);
+
+protected:
+    // Opens queue entry index, or unloads for -1, and starts it if play
+    virtual void load(int index, bool play) = 0;
+    // Loads index and makes it the current entry
+    void changeEntry(int index, bool play);
+    // Makes index current for a backend that already moved on to it
+    void setCurrentEntry(int index);
+    // Linear gain that levels entry index under the current mode, held
+    // down so its true peak stays below full scale; 1 if unmeasured
+    float replayGain(int index) const;
+
+private:
+    QList<QUrl> m_queue;
+    int m_index;    // -1 for none
+    int m_crossfade;
+    CrossfadeCurve m_curve;
+    QList<LoudnessInfo> m_loudness;
+    ReplayGainMode m_replayGain;
+};
+
+#endif // PLAYBACKBACKEND_H
@@ -0,0 +1,87 @@
+#include "playbackcore.h"
+#include "musiclibrary.h"
+#include "trace.h"
+
+PlaybackCore::PlaybackCore(QObject *parent)
+    : QObject(parent)
+    , m_player(nullptr)
+    , m_library(nullptr)
+{
+}
+
+PlaybackBackend *PlaybackCore::player()
+{
+    if (!m_player) {
+        m_player = PlaybackBackend::create(this);
+        connect(m_player, &PlaybackBackend::sourceChanged, this, &PlaybackCore::onSourceChanged);
+        connect(m_player, &PlaybackBackend::metaDataChanged, this, &PlaybackCore::onMetaDataChanged);
+    }
+    return m_player;
+}
+
+void PlaybackCore::setLibrary(MusicLibrary *library)
+{
+    m_library = library;
+    if (m_player) {
+        onSourceChanged(m_player->source());
+    }
+}
+
+void PlaybackCore::setQueue(const QList<QUrl> &queue, int index)
+{
+    QList<LoudnessInfo> loudness;
+    if (m_library) {
+        const TrackStore *store = m_library->trackStore();
+        loudness.reserve(queue.size());
+        for (const QUrl &url : queue) {
+            const int id = store->trackId(url.toLocalFile());
+            loudness.append(id >= 0 ? store->loudness(id) : LoudnessInfo());
+        }
+    }
+    player()->setQueue(queue, index, loudness);
+}
+
+void PlaybackCore::onSourceChanged(const QUrl &source)
+{
+    TRACE_SCOPE("resolve now playing");
+    const QString filePath = source.toLocalFile();
+    TrackInfo info;
+    if (m_library && !filePath.isEmpty()) {
+        // Only the store; reading the file here would parse it on the GUI
+        // thread while the decoder parses it again
+        const TrackStore *store = m_library->trackStore();
+        const int id = store->trackId(filePath);
+        if (id >= 0) {
+            info = store->track(id);
+        }
+    }
+    // Not in the library; the decoder's metadata fills it in when it comes
+    info.filePath = filePath;
+    m_nowPlaying = info;
+    emit nowPlayingChanged();
+}
+
+void PlaybackCore::onMetaDataChanged()
+{
+    if (m_nowPlaying.hasTags || m_nowPlaying.filePath.isEmpty()) {
+        return;
+    }
+
+    const QMediaMetaData metaData = m_player->metaData();
+    const QString title = metaData.stringValue(QMediaMetaData::Title);
+    QString artist = metaData.stringValue(QMediaMetaData::AlbumArtist);
+    if (artist.isEmpty()) {
+        artist = metaData.stringValue(QMediaMetaData::ContributingArtist);
+    }
+    if (title.isEmpty() && artist.isEmpty()) {
+        return;
+    }
+
+    m_nowPlaying.title = title;
+    m_nowPlaying.artist = artist;
+    m_nowPlaying.albumArtist = metaData.stringValue(QMediaMetaData::AlbumArtist);
+    m_nowPlaying.album = metaData.stringValue(QMediaMetaData::AlbumTitle);
+    m_nowPlaying.genre = metaData.stringValue(QMediaMetaData::Genre);
+    m_nowPlaying.hasTags = true;
+    emit nowPlayingChanged();
+}
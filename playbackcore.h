@@ -0,0 +1,44 @@
+#ifndef PLAYBACKCORE_H
+#define PLAYBACKCORE_H
+
+#include <QObject>
+#include "playbackbackend.h"
+#include "trackinfo.h"
+
+class MusicLibrary;
+
+// The app's one playback pipeline, shared by the widget UI and the QML
+// MusicPlayer. It owns the backend, which front ends send commands to,
+// and works out once per entry what is playing: from the library index
+// when the file is in it, else from what the backend's own decoder read.
+// No front end parses tags itself. The backend is only created on first
+// use, so a cold start can paint before the audio stack loads.
+class PlaybackCore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlaybackCore(QObject *parent = nullptr);
+
+    PlaybackBackend *player();
+    void setLibrary(MusicLibrary *library);
+    // Queues files on the player along with the loudness the library
+    // measured for them, for ReplayGain
+    void setQueue(const QList<QUrl> &queue, int index = 0);
+
+    // filePath is empty when nothing is loaded
+    const TrackInfo &nowPlaying() const { return m_nowPlaying; }
+
+signals:
+    void nowPlayingChanged();
+
+private:
+    void onSourceChanged(const QUrl &source);
+    void onMetaDataChanged();
+
+    PlaybackBackend *m_player;
+    MusicLibrary *m_library;
+    TrackInfo m_nowPlaying;
+};
+
+#endif // PLAYBACKCORE_H
@@ -0,0 +1,107 @@
+#include "ringbuffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    quint64 roundUpToPowerOfTwo(quint64 value)
+    {
+        quint64 result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+RingBuffer::RingBuffer(qsizetype capacity, int channels)
+    : m_channels(channels)
+    , m_mask(roundUpToPowerOfTwo(quint64(qMax<qsizetype>(capacity, 2))) - 1)
+    , m_samples(new float[(m_mask + 1) * quint64(channels)])
+    , m_write(0)
+    , m_read(0)
+    , m_discardTo(NoDiscard)
+{
+}
+
+qsizetype RingBuffer::write(const float *data, qsizetype frames)
+{
+    const quint64 position = m_write.load(std::memory_order_relaxed);
+    const quint64 read = m_read.load(std::memory_order_acquire);
+    const qsizetype count = std::min<qsizetype>(frames, qsizetype(capacity() - (position - read)));
+    if (count <= 0) {
+        return 0;
+    }
+
+    copyIn(position, data, count);
+    m_write.store(position + count, std::memory_order_release);
+    return count;
+}
+
+qsizetype RingBuffer::freeFrames() const
+{
+    return qsizetype(capacity() - (m_write.load(std::memory_order_relaxed) - m_read.load(std::memory_order_acquire)));
+}
+
+quint64 RingBuffer::writePosition() const
+{
+    return m_write.load(std::memory_order_relaxed);
+}
+
+void RingBuffer::discard()
+{
+    // The reader owns its position, so it does the skipping itself
+    m_discardTo.store(m_write.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+qsizetype RingBuffer::read(float *data, qsizetype frames)
+{
+    quint64 position = m_read.load(std::memory_order_relaxed);
+    const quint64 discardTo = m_discardTo.exchange(NoDiscard, std::memory_order_acquire);
+    if (discardTo != NoDiscard && discardTo > position) {
+        position = discardTo;
+    }
+
+    const quint64 write = m_write.load(std::memory_order_acquire);
+    const qsizetype count = std::min<qsizetype>(frames, qsizetype(write - position));
+    if (count > 0) {
+        copyOut(position, data, count);
+        position += count;
+    }
+    m_read.store(position, std::memory_order_release);
+    return std::max<qsizetype>(count, 0);
+}
+
+qsizetype RingBuffer::availableFrames() const
+{
+    quint64 position = m_read.load(std::memory_order_relaxed);
+    const quint64 discardTo = m_discardTo.load(std::memory_order_acquire);
+    if (discardTo != NoDiscard && discardTo > position) {
+        position = discardTo;
+    }
+    return qsizetype(m_write.load(std::memory_order_acquire) - position);
+}
+
+quint64 RingBuffer::readPosition() const
+{
+    return m_read.load(std::memory_order_acquire);
+}
+
+void RingBuffer::copyIn(quint64 position, const float *data, qsizetype frames)
+{
+    const quint64 offset = position & m_mask;
+    const qsizetype first = std::min<qsizetype>(frames, qsizetype(capacity() - offset));
+    std::memcpy(m_samples.get() + offset * m_channels, data, size_t(first) * m_channels * sizeof(float));
+    if (first < frames) {
+        std::memcpy(m_samples.get(), data + first * m_channels, size_t(frames - first) * m_channels * sizeof(float));
+    }
+}
+
+void RingBuffer::copyOut(quint64 position, float *data, qsizetype frames)
+{
+    const quint64 offset = position & m_mask;
+    const qsizetype first = std::min<qsizetype>(frames, qsizetype(capacity() - offset));
+    std::memcpy(data, m_samples.get() + offset * m_channels, size_t(first) * m_channels * sizeof(float));
+    if (first < frames) {
+        std::memcpy(data + first * m_channels, m_samples.get(), size_t(frames - first) * m_channels * sizeof(float));
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+// Single-producer, single-consumer ring of interleaved float frames. One
+// thread writes and one thread reads, without locks or allocation after
+// construction: each side owns its own position and only reads the
+// other's. Positions count frames since construction and never wrap, so
+// they double as a timeline for the audio that passed through.
+class RingBuffer
+{
+public:
+    // capacity is rounded up to a power of two frames
+    RingBuffer(qsizetype capacity, int channels);
+
+    int channels() const { return m_channels; }
+    qsizetype capacity() const { return m_mask + 1; }
+
+    // Producer side; writes whole frames, as many as fit
+    qsizetype write(const float *data, qsizetype frames);
+    qsizetype freeFrames() const;
+    quint64 writePosition() const;
+    // Everything written so far is skipped by the next read
+    void discard();
+
+    // Consumer side; reads up to frames, as many as are available
+    qsizetype read(float *data, qsizetype frames);
+    qsizetype availableFrames() const;
+    quint64 readPosition() const;
+
+private:
+    void copyIn(quint64 position, const float *data, qsizetype frames);
+    void copyOut(quint64 position, float *data, qsizetype frames);
+
+    static constexpr quint64 NoDiscard = ~quint64(0);
+
+    const int m_channels;
+    const quint64 m_mask;
+    std::unique_ptr<float[]> m_samples;
+
+    // Each position on its own cache line, so the two threads don't
+    // invalidate each other's on every update
+    alignas(64) std::atomic<quint64> m_write;
+    alignas(64) std::atomic<quint64> m_read;
+    alignas(64) std::atomic<quint64> m_discardTo;
+};
+
+#endif // RINGBUFFER_H
@@ -0,0 +1,283 @@
+#include "searchindex.h"
+#include <algorithm>
+
+namespace {
+    constexpr qsizetype MIN_GARBAGE = 1 << 20;
+
+    quint64 trigram(char16_t a, char16_t b, char16_t c)
+    {
+        return (quint64(a) << 32) | (quint64(b) << 16) | quint64(c);
+    }
+
+    bool isHangulSyllable(QChar ch)
+    {
+        return ch.unicode() >= 0xac00 && ch.unicode() <= 0xd7a3;
+    }
+
+    template <typename Function>
+    void forEachWord(QStringView text, Function function)
+    {
+        qsizetype start = -1;
+        for (qsizetype i = 0; i <= text.size(); ++i) {
+            const bool inWord = i < text.size() && text.at(i).isLetterOrNumber();
+            if (inWord && start < 0) {
+                start = i;
+            } else if (!inWord && start >= 0) {
+                function(text.mid(start, i - start));
+                start = -1;
+            }
+        }
+    }
+
+    // Distinct trigrams of every word, plus the padded ones for its first
+    // one and two letters
+    QVector<quint64> documentTrigrams(const QString &folded)
+    {
+        QVector<quint64> keys;
+        forEachWord(folded, [&keys](QStringView word) {
+            keys.append(trigram(0, 0, word.at(0).unicode()));
+            if (word.size() > 1) {
+                keys.append(trigram(0, word.at(0).unicode(), word.at(1).unicode()));
+            }
+            for (qsizetype i = 0; i + 2 < word.size(); ++i) {
+                keys.append(trigram(word.at(i).unicode(), word.at(i + 1).unicode(), word.at(i + 2).unicode()));
+            }
+        });
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        return keys;
+    }
+
+    void addPosting(QVector<int> &list, int id)
+    {
+        if (list.isEmpty() || list.last() < id) {
+            list.append(id);
+            return;
+        }
+        const auto it = std::lower_bound(list.begin(), list.end(), id);
+        if (it == list.end() || *it != id) {
+            list.insert(it, id);
+        }
+    }
+
+    void removePosting(QHash<quint64, QVector<int>> &postings, quint64 key, int id)
+    {
+        const auto found = postings.find(key);
+        if (found == postings.end()) {
+            return;
+        }
+        QVector<int> &list = found.value();
+        const auto it = std::lower_bound(list.begin(), list.end(), id);
+        if (it != list.end() && *it == id) {
+            list.erase(it);
+        }
+        if (list.isEmpty()) {
+            postings.erase(found);
+        }
+    }
+}
+
+SearchIndex::SearchIndex(TrackStore *store, QObject *parent)
+    : QObject(parent)
+    , m_store(store)
+    , m_titleGarbage(0)
+    , m_namesIndexed(0)
+{
+    connect(m_store, &TrackStore::tracksInserted, this, &SearchIndex::addTracks);
+    connect(m_store, &TrackStore::tracksChanged, this, &SearchIndex::addTracks);
+    connect(m_store, &TrackStore::tracksAboutToChange, this, &SearchIndex::removeTracks);
+    connect(m_store, &TrackStore::tracksAboutToBeRemoved, this, &SearchIndex::removeTracks);
+}
+
+QString SearchIndex::fold(const QString &text)
+{
+    QString folded;
+    folded.reserve(text.size());
+    for (QChar ch : text) {
+        if (ch.unicode() < 0x80) {
+            folded.append(ch.toLower());
+            continue;
+        }
+
+        // Keep the base letter of precomposed characters and drop marks.
+        // Hangul syllables decompose into jamo, not a letter and marks,
+        // so they stay whole
+        while (!isHangulSyllable(ch) && ch.decompositionTag() == QChar::Canonical) {
+            ch = ch.decomposition().at(0);
+        }
+        if (ch.category() != QChar::Mark_NonSpacing) {
+            folded.append(ch.toCaseFolded());
+        }
+    }
+    return folded;
+}
+
+QVector<int> SearchIndex::search(const QString &query) const
+{
+    QStringList words;
+    forEachWord(fold(query), [&words](QStringView word) {
+        words.append(word.toString());
+    });
+    words.removeDuplicates();
+
+    // Longest words are the most selective, so they narrow the result first
+    std::sort(words.begin(), words.end(), [](const QString &a, const QString &b) {
+        return a.size() > b.size();
+    });
+
+    QVector<int> result;
+    for (int i = 0; i < words.size(); ++i) {
+        const QVector<int> matches = matchWord(words.at(i));
+        if (i == 0) {
+            result = matches;
+        } else {
+            QVector<int> both;
+            std::set_intersection(result.cbegin(), result.cend(), matches.cbegin(), matches.cend(),
+                                  std::back_inserter(both));
+            result = both;
+        }
+        if (result.isEmpty()) {
+            break;
+        }
+    }
+    return result;
+}
+
+QVector<int> SearchIndex::matchWord(const QString &word) const
+{
+    // Up to three letters the trigrams are exact; longer words are checked
+    // against the text since their trigrams need not be adjacent
+    const bool verify = word.size() > 3;
+
+    QVector<int> titles = lookup(m_titles, word);
+    if (verify) {
+        titles.removeIf([this, &word](int id) {
+            return !foldedTitle(id).contains(word);
+        });
+    }
+
+    QVector<int> names = lookup(m_names, word);
+    if (verify) {
+        names.removeIf([this, &word](int nameId) {
+            return !m_foldedNames.at(nameId).contains(word);
+        });
+    }
+    if (names.isEmpty()) {
+        return titles;
+    }
+
+    const QVector<int> byName = m_store->tracksWithNames(names);
+
+    QVector<int> result;
+    result.reserve(titles.size() + byName.size());
+    std::set_union(titles.cbegin(), titles.cend(), byName.cbegin(), byName.cend(),
+                   std::back_inserter(result));
+    return result;
+}
+
+QVector<int> SearchIndex::lookup(const Postings &postings, const QString &word)
+{
+    QVector<quint64> keys;
+    if (word.size() == 1) {
+        keys.append(trigram(0, 0, word.at(0).unicode()));
+    } else if (word.size() == 2) {
+        keys.append(trigram(0, word.at(0).unicode(), word.at(1).unicode()));
+    } else {
+        for (qsizetype i = 0; i + 2 < word.size(); ++i) {
+            keys.append(trigram(word.at(i).unicode(), word.at(i + 1).unicode(), word.at(i + 2).unicode()));
+        }
+    }
+
+    // Intersect starting from the shortest list, probing the longer ones
+    QVector<const QVector<int> *> lists;
+    for (quint64 key : std::as_const(keys)) {
+        const auto it = postings.constFind(key);
+        if (it == postings.constEnd()) {
+            return QVector<int>();
+        }
+        lists.append(&it.value());
+    }
+    std::sort(lists.begin(), lists.end(), [](const QVector<int> *a, const QVector<int> *b) {
+        return a->size() < b->size();
+    });
+
+    QVector<int> result = *lists.first();
+    for (int i = 1; i < lists.size() && !result.isEmpty(); ++i) {
+        const QVector<int> &list = *lists.at(i);
+        result.removeIf([&list](int id) {
+            return !std::binary_search(list.cbegin(), list.cend(), id);
+        });
+    }
+    return result;
+}
+
+void SearchIndex::addTracks(const QVector<int> &ids)
+{
+    indexNames();
+    if (m_titleOffset.size() < m_store->idLimit()) {
+        m_titleOffset.resize(m_store->idLimit());
+        m_titleLength.resize(m_store->idLimit());
+    }
+    for (int id : ids) {
+        const QString folded = fold(m_store->title(id));
+        m_titleOffset[id] = quint32(m_titleText.size());
+        m_titleLength[id] = quint16(qMin<qsizetype>(folded.size(), 0xffff));
+        m_titleText.append(QStringView(folded).left(m_titleLength.at(id)));
+
+        const QVector<quint64> keys = documentTrigrams(folded);
+        for (quint64 key : keys) {
+            addPosting(m_titles[key], id);
+        }
+    }
+}
+
+void SearchIndex::removeTracks(const QVector<int> &ids)
+{
+    for (int id : ids) {
+        if (id >= m_titleOffset.size()) {
+            continue;
+        }
+        const QVector<quint64> keys = documentTrigrams(foldedTitle(id).toString());
+        for (quint64 key : keys) {
+            removePosting(m_titles, key, id);
+        }
+        m_titleGarbage += m_titleLength.at(id);
+        m_titleLength[id] = 0;
+    }
+    compactTitles();
+}
+
+QStringView SearchIndex::foldedTitle(int id) const
+{
+    return QStringView(m_titleText).mid(m_titleOffset.at(id), m_titleLength.at(id));
+}
+
+void SearchIndex::compactTitles()
+{
+    // Removed titles are left in place until they dominate
+    if (m_titleGarbage < MIN_GARBAGE || m_titleGarbage < m_titleText.size() / 2) {
+        return;
+    }
+
+    QString text;
+    text.reserve(m_titleText.size() - m_titleGarbage);
+    for (int id = 0; id < m_titleOffset.size(); ++id) {
+        const quint32 offset = quint32(text.size());
+        text.append(foldedTitle(id));
+        m_titleOffset[id] = offset;
+    }
+    m_titleText = text;
+    m_titleGarbage = 0;
+}
+
+void SearchIndex::indexNames()
+{
+    // Names are never dropped from the pool, so only new ones need work
+    for (; m_namesIndexed < m_store->nameCount(); ++m_namesIndexed) {
+        m_foldedNames.append(fold(m_store->name(m_namesIndexed)));
+        const QVector<quint64> keys = documentTrigrams(m_foldedNames.last());
+        for (quint64 key : keys) {
+            m_names[key].append(m_namesIndexed);
+        }
+    }
+}
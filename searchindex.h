@@ -0,0 +1,52 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include "trackstore.h"
+
+// Trigram index over titles, artists and albums, kept in step with the
+// track store. Text is case- and diacritic-folded and split into words;
+// each word also yields padded trigrams for its first one and two letters,
+// so short queries match word prefixes and longer ones any substring.
+// Titles are indexed per track, artists and albums once per interned name.
+// The folded text is kept too, for checking longer words without folding
+// the candidates again on every query.
+class SearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SearchIndex(TrackStore *store, QObject *parent = nullptr);
+
+    // Ids of the tracks matching every word of query, in id order
+    QVector<int> search(const QString &query) const;
+
+    static QString fold(const QString &text);
+
+private slots:
+    void addTracks(const QVector<int> &ids);
+    void removeTracks(const QVector<int> &ids);
+    void indexNames();
+
+private:
+    using Postings = QHash<quint64, QVector<int>>;
+
+    QVector<int> matchWord(const QString &word) const;
+    static QVector<int> lookup(const Postings &postings, const QString &word);
+    QStringView foldedTitle(int id) const;
+    void compactTitles();
+
+    TrackStore *m_store;
+    Postings m_titles;  // trigram -> track ids
+    Postings m_names;   // trigram -> name ids
+    QString m_titleText;            // folded titles, by the offsets below
+    QVector<quint32> m_titleOffset; // by track id
+    QVector<quint16> m_titleLength;
+    qsizetype m_titleGarbage;
+    QVector<QString> m_foldedNames; // by name id
+    int m_namesIndexed;
+};
+
+#endif // SEARCHINDEX_H
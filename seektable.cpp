@@ -0,0 +1,386 @@
+#include "seektable.h"
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // A point about every half second keeps tables small, and what is
+    // decoded past a point and dropped short
+    constexpr int POINTS_PER_SECOND = 2;
+
+    // Frames decoded ahead of an MP3 seek target: the bit reservoir can
+    // reach back into the previous frame, and the first frame out of a
+    // fresh decoder is not yet overlapped
+    constexpr int MPEG_PREROLL_FRAMES = 2;
+
+    // Delay every MP3 decoder adds, on top of the encoder's own
+    constexpr int MPEG_DECODER_DELAY = 529;
+
+    quint32 be16(const uchar *p) { return quint32(p[0]) << 8 | p[1]; }
+    quint32 be24(const uchar *p) { return quint32(p[0]) << 16 | be16(p + 1); }
+    quint32 be32(const uchar *p) { return quint32(p[0]) << 24 | be24(p + 1); }
+    quint64 be64(const uchar *p) { return quint64(be32(p)) << 32 | be32(p + 4); }
+
+    // Bytes of a leading ID3v2 tag, 0 if there is none
+    qint64 id3Size(const uchar *data, qint64 size)
+    {
+        if (size < 10 || std::memcmp(data, "ID3", 3) != 0) {
+            return 0;
+        }
+        const qint64 body = qint64(data[6] & 0x7f) << 21 | (data[7] & 0x7f) << 14
+                          | (data[8] & 0x7f) << 7 | (data[9] & 0x7f);
+        const bool footer = data[5] & 0x10;
+        return qMin(size, 10 + body + (footer ? 10 : 0));
+    }
+
+    struct MpegFrame
+    {
+        int length = 0;         // bytes, header included
+        int samples = 0;
+        int sampleRate = 0;
+        int sideInfo = 0;       // Layer III side info bytes after the header
+    };
+
+    // Layers II and III; Layer I files are too rare to bother with
+    bool parseMpegHeader(const uchar *p, MpegFrame *frame)
+    {
+        static const int MPEG1_LAYER3[] = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
+        static const int MPEG1_LAYER2[] = {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384};
+        static const int MPEG2[] = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160};
+        static const int RATES[] = {44100, 48000, 32000};
+
+        if (p[0] != 0xff || (p[1] & 0xe0) != 0xe0) {
+            return false;
+        }
+        const int version = (p[1] >> 3) & 3;    // 0 MPEG 2.5, 2 MPEG 2, 3 MPEG 1
+        const int layer = (p[1] >> 1) & 3;      // 1 Layer III, 2 Layer II
+        const int bitrateIndex = p[2] >> 4;
+        const int rateIndex = (p[2] >> 2) & 3;
+        if (version == 1 || (layer != 1 && layer != 2)
+                || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) {
+            return false;
+        }
+
+        const bool mpeg1 = version == 3;
+        const bool layer3 = layer == 1;
+        const int bitrate = mpeg1 ? (layer3 ? MPEG1_LAYER3 : MPEG1_LAYER2)[bitrateIndex] : MPEG2[bitrateIndex];
+        const bool mono = (p[3] >> 6) == 3;
+        frame->sampleRate = RATES[rateIndex] >> (mpeg1 ? 0 : version == 2 ? 1 : 2);
+        frame->samples = layer3 && !mpeg1 ? 576 : 1152;
+        frame->length = frame->samples / 8 * bitrate * 1000 / frame->sampleRate + ((p[2] >> 1) & 1);
+        frame->sideInfo = !layer3 ? 0 : mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+        return true;
+    }
+
+    quint8 crc8(const uchar *p, int length)
+    {
+        quint8 crc = 0;
+        for (int i = 0; i < length; ++i) {
+            crc ^= p[i];
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = crc & 0x80 ? quint8(crc << 1 ^ 0x07) : quint8(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    struct FlacFrame
+    {
+        qint64 number = 0;      // frame number, or first sample if variable
+        bool variable = false;
+        int blockSize = 0;
+    };
+
+    // p has at least 16 bytes, the longest a frame header gets
+    bool parseFlacHeader(const uchar *p, FlacFrame *frame)
+    {
+        if (p[0] != 0xff || (p[1] & 0xfe) != 0xf8) {
+            return false;
+        }
+        const int blockCode = p[2] >> 4;
+        const int rateCode = p[2] & 0x0f;
+        if (blockCode == 0 || rateCode == 15 || (p[3] >> 4) > 10 || ((p[3] >> 1) & 7) == 3 || (p[3] & 1)) {
+            return false;
+        }
+
+        // The number is coded like UTF-8, up to seven bytes
+        int ones = 0;
+        while (ones < 8 && (p[4] & (0x80 >> ones))) {
+            ++ones;
+        }
+        if (ones == 1 || ones == 8) {
+            return false;
+        }
+        int n = 4;
+        const int extra = qMax(ones - 1, 0);
+        qint64 number = p[n++] & (0xff >> (ones + 1));
+        for (int i = 0; i < extra; ++i, ++n) {
+            if ((p[n] & 0xc0) != 0x80) {
+                return false;
+            }
+            number = number << 6 | (p[n] & 0x3f);
+        }
+
+        int blockSize;
+        if (blockCode == 1) {
+            blockSize = 192;
+        } else if (blockCode <= 5) {
+            blockSize = 576 << (blockCode - 2);
+        } else if (blockCode == 6) {
+            blockSize = p[n++] + 1;
+        } else if (blockCode == 7) {
+            blockSize = int(be16(p + n)) + 1;
+            n += 2;
+        } else {
+            blockSize = 256 << (blockCode - 8);
+        }
+        if (rateCode == 12) {
+            n += 1;
+        } else if (rateCode == 13 || rateCode == 14) {
+            n += 2;
+        }
+
+        if (crc8(p, n) != p[n]) {
+            return false;
+        }
+        frame->number = number;
+        frame->variable = p[1] & 1;
+        frame->blockSize = blockSize;
+        return true;
+    }
+}
+
+SeekTable::SeekTable()
+    : m_sampleRate(0)
+    , m_samples(0)
+    , m_headerSize(0)
+    , m_preroll(0)
+{
+}
+
+SeekTable SeekTable::build(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < 16) {
+        return SeekTable();
+    }
+
+    // Mapped, the whole file is walked without copying it
+    const qint64 size = file.size();
+    const uchar *data = file.map(0, size);
+    QByteArray contents;
+    if (!data) {
+        contents = file.readAll();
+        data = reinterpret_cast<const uchar *>(contents.constData());
+    }
+
+    const qint64 tag = id3Size(data, size);
+    if (size - tag >= 4 && std::memcmp(data + tag, "fLaC", 4) == 0) {
+        return buildFlac(data, size);
+    }
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    if (suffix == "mp3" || suffix == "mp2" || suffix == "mpga") {
+        return buildMpeg(data, size);
+    }
+    return SeekTable();
+}
+
+SeekTable SeekTable::buildMpeg(const uchar *data, qint64 size)
+{
+    SeekTable table;
+    qint64 pos = id3Size(data, size);
+    qint64 frames = 0;
+    int frameSamples = 0;
+    qint64 skip = 0;        // samples the decoder drops at the start
+    qint64 padding = 0;     // and at the end
+    qint64 interval = 0;
+    qint64 nextPoint = 0;
+    bool first = true;
+
+    while (pos + 4 <= size) {
+        // Only a header followed by another one, a tag or the end counts,
+        // so junk and stray sync bytes are passed over
+        MpegFrame frame;
+        if (!parseMpegHeader(data + pos, &frame) || pos + frame.length > size) {
+            ++pos;
+            continue;
+        }
+        const qint64 end = pos + frame.length;
+        MpegFrame next;
+        if (end + 4 <= size && std::memcmp(data + end, "TAG", 3) != 0
+                && (!parseMpegHeader(data + end, &next) || next.sampleRate != frame.sampleRate)) {
+            ++pos;
+            continue;
+        }
+
+        if (first) {
+            first = false;
+            table.m_sampleRate = frame.sampleRate;
+            frameSamples = frame.samples;
+            table.m_preroll = MPEG_PREROLL_FRAMES * frame.samples;
+            interval = frame.sampleRate / POINTS_PER_SECOND;
+
+            // A Xing/Info or VBRI frame holds no audio. LAME's extension
+            // of it gives the encoder delay the decoder trims, which the
+            // sample numbers have to allow for
+            const uchar *xing = data + pos + 4 + frame.sideInfo;
+            const uchar *frameEnd = data + end;
+            if (xing + 8 <= frameEnd && (std::memcmp(xing, "Xing", 4) == 0 || std::memcmp(xing, "Info", 4) == 0)) {
+                const quint32 flags = be32(xing + 4);
+                const uchar *lame = xing + 8 + (flags & 1 ? 4 : 0) + (flags & 2 ? 4 : 0)
+                                  + (flags & 4 ? 100 : 0) + (flags & 8 ? 4 : 0);
+                if (lame + 24 <= frameEnd && (std::memcmp(lame, "LAME", 4) == 0
+                        || std::memcmp(lame, "Lavf", 4) == 0 || std::memcmp(lame, "Lavc", 4) == 0)) {
+                    skip = (lame[21] << 4 | lame[22] >> 4) + MPEG_DECODER_DELAY;
+                    padding = (lame[22] & 0x0f) << 8 | lame[23];
+                }
+                pos = end;
+                continue;
+            }
+            if (data + pos + 4 + 32 + 4 <= frameEnd && std::memcmp(data + pos + 4 + 32, "VBRI", 4) == 0) {
+                pos = end;
+                continue;
+            }
+        }
+
+        const qint64 sample = frames * frameSamples - skip;
+        if (sample >= nextPoint && sample > 0) {
+            table.m_points.append({sample, pos});
+            nextPoint = sample + interval;
+        }
+        ++frames;
+        pos = end;
+    }
+
+    if (frames == 0) {
+        return SeekTable();
+    }
+    table.m_samples = qMax<qint64>(frames * frameSamples - skip - padding, 0);
+    return table;
+}
+
+SeekTable SeekTable::buildFlac(const uchar *data, qint64 size)
+{
+    SeekTable table;
+    qint64 pos = id3Size(data, size) + 4;
+    int blockSize = 0;
+    QVector<Point> stored;
+
+    // Metadata blocks, up to the first frame
+    bool last = false;
+    while (!last && pos + 4 <= size) {
+        last = data[pos] & 0x80;
+        const int type = data[pos] & 0x7f;
+        const qint64 length = be24(data + pos + 1);
+        const uchar *body = data + pos + 4;
+        if (pos + 4 + length > size) {
+            return SeekTable();
+        }
+
+        if (type == 0 && length >= 18) {
+            // STREAMINFO
+            if (be16(body) == be16(body + 2)) {
+                blockSize = int(be16(body));
+            }
+            table.m_sampleRate = int(be24(body + 10) >> 4);
+            table.m_samples = qint64(body[13] & 0x0f) << 32 | be32(body + 14);
+        } else if (type == 3) {
+            // SEEKTABLE; offsets count from the first frame
+            for (qint64 i = 0; i + 18 <= length; i += 18) {
+                const quint64 sample = be64(body + i);
+                const quint64 offset = be64(body + i + 8);
+                if (sample != ~quint64(0) && sample > 0 && offset < quint64(size)) {
+                    stored.append({qint64(sample), qint64(offset)});
+                }
+            }
+        }
+        pos += 4 + length;
+    }
+    if (!last || table.m_sampleRate <= 0) {
+        return SeekTable();
+    }
+    table.m_headerSize = pos;
+
+    if (!stored.isEmpty()) {
+        for (Point &point : stored) {
+            point.offset += table.m_headerSize;
+        }
+        table.m_points = stored;
+        return table;
+    }
+
+    // No SEEKTABLE: find the frames. Each must carry the number that
+    // follows the last, which rules out sync codes in the audio data
+    const qint64 interval = table.m_sampleRate / POINTS_PER_SECOND;
+    qint64 expected = 0;
+    qint64 nextPoint = interval;
+    while (pos + 16 <= size) {
+        const void *sync = std::memchr(data + pos, 0xff, size_t(size - 16 - pos + 1));
+        if (!sync) {
+            break;
+        }
+        pos = static_cast<const uchar *>(sync) - data;
+
+        FlacFrame frame;
+        if (parseFlacHeader(data + pos, &frame)) {
+            const qint64 sample = frame.variable ? frame.number : frame.number * blockSize;
+            if (sample == expected && (frame.variable || blockSize > 0)) {
+                if (sample >= nextPoint) {
+                    table.m_points.append({sample, pos});
+                    nextPoint = sample + interval;
+                }
+                expected += frame.blockSize;
+            }
+        }
+        ++pos;
+    }
+    if (table.m_samples == 0) {
+        table.m_samples = expected;
+    }
+    return table;
+}
+
+SeekTable::Point SeekTable::find(qint64 sample) const
+{
+    const qint64 target = sample - m_preroll;
+    const auto it = std::upper_bound(m_points.cbegin(), m_points.cend(), target,
+                                     [](qint64 value, const Point &point) {
+        return value < point.sample;
+    });
+    return it == m_points.cbegin() ? Point() : *(it - 1);
+}
+
+QDataStream &operator<<(QDataStream &out, const SeekTable &table)
+{
+    out << qint32(table.m_sampleRate) << table.m_samples << table.m_headerSize << table.m_preroll
+        << qint32(table.m_points.size());
+    for (const SeekTable::Point &point : table.m_points) {
+        out << point.sample << point.offset;
+    }
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, SeekTable &table)
+{
+    qint32 sampleRate = 0;
+    qint32 count = 0;
+    in >> sampleRate >> table.m_samples >> table.m_headerSize >> table.m_preroll >> count;
+    // The count is only trusted as far as the rest of the data could hold it
+    constexpr qint64 POINT_SIZE = 2 * sizeof(qint64);
+    if (in.status() != QDataStream::Ok || sampleRate <= 0 || count < 0
+            || !in.device() || count > in.device()->bytesAvailable() / POINT_SIZE) {
+        in.setStatus(QDataStream::ReadCorruptData);
+        return in;
+    }
+
+    table.m_sampleRate = sampleRate;
+    table.m_points.clear();
+    table.m_points.reserve(count);
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        SeekTable::Point point;
+        in >> point.sample >> point.offset;
+        table.m_points.append(point);
+    }
+    return in;
+}
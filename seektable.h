@@ -0,0 +1,55 @@
+#ifndef SEEKTABLE_H
+#define SEEKTABLE_H
+
+#include <QDataStream>
+#include <QString>
+#include <QVector>
+
+// Where to start decoding a file to reach a given sample without going
+// through everything before it. Each point pairs the first sample of a
+// frame with the frame's byte offset, about every half second. MP3 tables
+// come from walking the frame headers; FLAC ones from the file's own
+// SEEKTABLE, or from walking its frames when it has none. A decoder fed
+// the first headerSize() bytes and then the file from a point's offset
+// produces that point's samples first.
+class SeekTable
+{
+public:
+    struct Point
+    {
+        qint64 sample = 0;
+        qint64 offset = 0;
+    };
+
+    // Null for other formats, or files that do not parse
+    static SeekTable build(const QString &filePath);
+
+    SeekTable();
+
+    bool isNull() const { return m_points.isEmpty(); }
+    int sampleRate() const { return m_sampleRate; }
+    qint64 sampleCount() const { return m_samples; }
+    qint64 headerSize() const { return m_headerSize; }
+
+    // The last point far enough before sample for the decoder to have
+    // settled by then; a default Point, meaning the start, if none
+    Point find(qint64 sample) const;
+
+private:
+    friend QDataStream &operator<<(QDataStream &out, const SeekTable &table);
+    friend QDataStream &operator>>(QDataStream &in, SeekTable &table);
+
+    static SeekTable buildMpeg(const uchar *data, qint64 size);
+    static SeekTable buildFlac(const uchar *data, qint64 size);
+
+    int m_sampleRate;
+    qint64 m_samples;       // whole track, after any encoder delay
+    qint64 m_headerSize;    // bytes before the first frame the decoder needs
+    qint64 m_preroll;       // samples decoded before output is right
+    QVector<Point> m_points;
+};
+
+QDataStream &operator<<(QDataStream &out, const SeekTable &table);
+QDataStream &operator>>(QDataStream &in, SeekTable &table);
+
+#endif // SEEKTABLE_H
@@ -0,0 +1,45 @@
+#include "seektablestore.h"
+#include "cachefile.h"
+#include "waveformstore.h"
+
+namespace SeekTableStore {
+
+namespace {
+    constexpr quint32 SEEKTABLE_MAGIC = 0x4d53454b; // "MSEK"
+    constexpr quint32 SEEKTABLE_VERSION = 1;
+
+    const CacheFile<SeekTable> &cache()
+    {
+        static const CacheFile<SeekTable> file(QStringLiteral("seektables"), QStringLiteral(".seek"),
+                                               SEEKTABLE_MAGIC, SEEKTABLE_VERSION);
+        return file;
+    }
+}
+
+bool contains(const QString &key)
+{
+    return cache().contains(key);
+}
+
+bool store(const QString &key, const SeekTable &table)
+{
+    return cache().store(key, table);
+}
+
+SeekTable load(const QString &key)
+{
+    return cache().load(key);
+}
+
+SeekTable get(const QString &filePath, qint64 size, qint64 modified)
+{
+    const QString key = WaveformStore::key(filePath, size, modified);
+    SeekTable table = load(key);
+    if (table.isNull()) {
+        table = SeekTable::build(filePath);
+        store(key, table);
+    }
+    return table;
+}
+
+}
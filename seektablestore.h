@@ -0,0 +1,19 @@
+#ifndef SEEKTABLESTORE_H
+#define SEEKTABLESTORE_H
+
+#include <QString>
+#include "seektable.h"
+
+// On-disk cache of seek tables, beside the waveforms and under the same
+// keys (WaveformStore::key()). Safe to call from any thread.
+namespace SeekTableStore {
+    bool contains(const QString &key);
+    bool store(const QString &key, const SeekTable &table);
+    // Null if not stored or unreadable
+    SeekTable load(const QString &key);
+
+    // The stored table, else one built from the file and stored
+    SeekTable get(const QString &filePath, qint64 size, qint64 modified);
+}
+
+#endif // SEEKTABLESTORE_H
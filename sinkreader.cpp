@@ -0,0 +1,174 @@
+#include "sinkreader.h"
+#include "mixer.h"
+#include <algorithm>
+
+namespace {
+    // Frames mixed at a time; fade curves are followed linearly within a
+    // block, which at ~20 ms is far below what can be heard
+    constexpr qsizetype BLOCK_FRAMES = 1024;
+}
+
+SinkReader::SinkReader(RingBuffer *deck0, RingBuffer *deck1, const QAudioFormat &format, QObject *parent)
+    : QIODevice(parent)
+    , m_decks{ deck0, deck1 }
+    , m_float(format.sampleFormat() == QAudioFormat::Float)
+    , m_channels(format.channelCount())
+    , m_bytesPerFrame(format.bytesPerFrame())
+    , m_volume(1.0f)
+    , m_requestSerial(0)
+    , m_requestDeck(0)
+    , m_requestStart(0)
+    , m_requestLength(0)
+    , m_requestCurve(int(CrossfadeCurve::EqualPower))
+    , m_completed(0)
+    , m_seenSerial(0)
+    , m_main(0)
+    , m_pending(false)
+    , m_fading(false)
+    , m_faded(0)
+    , m_mix(new float[BLOCK_FRAMES * format.channelCount()])
+    , m_input(new float[BLOCK_FRAMES * format.channelCount()])
+{
+}
+
+float SinkReader::volume() const
+{
+    return m_volume.load(std::memory_order_relaxed);
+}
+
+void SinkReader::setVolume(float volume)
+{
+    m_volume.store(volume, std::memory_order_relaxed);
+}
+
+quint32 SinkReader::requestSwitch(int deck, quint64 start, qsizetype length, CrossfadeCurve curve)
+{
+    const quint32 serial = m_requestSerial.load(std::memory_order_relaxed) + 2;
+    m_requestSerial.store(serial - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_requestDeck.store(deck, std::memory_order_relaxed);
+    m_requestStart.store(start, std::memory_order_relaxed);
+    m_requestLength.store(length, std::memory_order_relaxed);
+    m_requestCurve.store(int(curve), std::memory_order_relaxed);
+    m_requestSerial.store(serial, std::memory_order_release);
+    return serial;
+}
+
+quint32 SinkReader::completedRequest() const
+{
+    return m_completed.load(std::memory_order_acquire);
+}
+
+bool SinkReader::takeRequest(Request *request)
+{
+    const quint32 serial = m_requestSerial.load(std::memory_order_acquire);
+    if (serial == m_seenSerial || (serial & 1)) {
+        return false;
+    }
+    request->deck = m_requestDeck.load(std::memory_order_relaxed);
+    request->start = m_requestStart.load(std::memory_order_relaxed);
+    request->length = m_requestLength.load(std::memory_order_relaxed);
+    request->curve = CrossfadeCurve(m_requestCurve.load(std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_requestSerial.load(std::memory_order_relaxed) != serial) {
+        return false;   // rewritten meanwhile; picked up on the next call
+    }
+    request->serial = serial;
+    m_seenSerial = serial;
+    return true;
+}
+
+bool SinkReader::isSequential() const
+{
+    return true;
+}
+
+qint64 SinkReader::bytesAvailable() const
+{
+    // There is always something to read, if only silence
+    return QIODevice::bytesAvailable() + m_decks[0]->capacity() * m_bytesPerFrame;
+}
+
+qint64 SinkReader::readData(char *data, qint64 maxSize)
+{
+    Request request;
+    if (takeRequest(&request)) {
+        if (request.length <= 0) {
+            m_main = request.deck;
+            m_pending = false;
+            m_fading = false;
+            m_completed.store(request.serial, std::memory_order_release);
+        } else {
+            m_fade = request;
+            m_pending = true;
+            m_fading = false;
+        }
+    }
+
+    const qsizetype frames = maxSize / m_bytesPerFrame;
+    const float volume = m_volume.load(std::memory_order_relaxed);
+    qsizetype done = 0;
+    while (done < frames) {
+        qsizetype count = std::min(frames - done, BLOCK_FRAMES);
+        if (m_pending) {
+            // Stop the block right where the fade begins
+            const quint64 position = m_decks[m_main]->readPosition();
+            if (position >= m_fade.start) {
+                m_pending = false;
+                m_fading = true;
+                m_faded = 0;
+            } else {
+                count = std::min<qsizetype>(count, qsizetype(m_fade.start - position));
+            }
+        }
+        if (m_fading) {
+            count = std::min(count, m_fade.length - m_faded);
+        }
+
+        float *out = m_float ? reinterpret_cast<float *>(data) + done * m_channels : m_mix.get();
+        const qsizetype read = m_decks[m_main]->read(out, count);
+        std::fill(out + read * m_channels, out + count * m_channels, 0.0f);
+        if (m_fading) {
+            mixFade(out, count);
+        }
+        if (volume != 1.0f) {
+            Mixer::scale(out, count * m_channels, volume);
+        }
+        if (!m_float) {
+            qint16 *to = reinterpret_cast<qint16 *>(data) + done * m_channels;
+            for (qsizetype i = 0; i < count * m_channels; ++i) {
+                to[i] = qint16(std::clamp(out[i], -1.0f, 1.0f) * 32767.0f);
+            }
+        }
+        done += count;
+    }
+    return qint64(frames) * m_bytesPerFrame;
+}
+
+void SinkReader::mixFade(float *out, qsizetype frames)
+{
+    const qsizetype read = m_decks[m_fade.deck]->read(m_input.get(), frames);
+    std::fill(m_input.get() + read * m_channels, m_input.get() + frames * m_channels, 0.0f);
+
+    const float from = float(m_faded) / float(m_fade.length);
+    const float to = float(m_faded + frames) / float(m_fade.length);
+    const float outGain = Mixer::fadeOutGain(m_fade.curve, from);
+    const float inGain = Mixer::fadeInGain(m_fade.curve, from);
+    Mixer::crossfade(out, m_input.get(), frames, m_channels,
+                     outGain, (Mixer::fadeOutGain(m_fade.curve, to) - outGain) / float(frames),
+                     inGain, (Mixer::fadeInGain(m_fade.curve, to) - inGain) / float(frames));
+
+    m_faded += frames;
+    if (m_faded >= m_fade.length) {
+        m_main = m_fade.deck;
+        m_fading = false;
+        m_completed.store(m_fade.serial, std::memory_order_release);
+    }
+}
+
+qint64 SinkReader::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
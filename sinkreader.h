@@ -0,0 +1,81 @@
+#ifndef SINKREADER_H
+#define SINKREADER_H
+
+#include <QAudioFormat>
+#include <QIODevice>
+#include <atomic>
+#include <memory>
+#include "common.h"
+#include "ringbuffer.h"
+
+// What the audio sink pulls from. Audio comes from one of two decks, each
+// a ring the decoder worker fills; during a crossfade both are read and
+// mixed. Runs on whatever thread the audio backend calls it from, so it
+// only touches the consumer side of the rings and atomics: no locks, no
+// allocation. Gaps are filled with silence, so the sink never runs dry
+// and stops asking.
+//
+// The worker switches decks with requests, published through a seqlock.
+// A request either cuts over right away (length 0) or crossfades into
+// the deck once the current deck has been read up to start.
+class SinkReader : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    SinkReader(RingBuffer *deck0, RingBuffer *deck1, const QAudioFormat &format, QObject *parent = nullptr);
+
+    float volume() const;
+    void setVolume(float volume);
+
+    // Called from the decoder worker only; returns the request's serial
+    quint32 requestSwitch(int deck, quint64 start, qsizetype length, CrossfadeCurve curve);
+    // Serial of the last request that has been carried out completely
+    quint32 completedRequest() const;
+
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    struct Request
+    {
+        quint32 serial = 0;
+        int deck = 0;
+        quint64 start = 0;
+        qsizetype length = 0;
+        CrossfadeCurve curve = CrossfadeCurve::EqualPower;
+    };
+
+    bool takeRequest(Request *request);
+    void mixFade(float *out, qsizetype frames);
+
+    RingBuffer *m_decks[2];
+    const bool m_float;     // else 16-bit integer samples
+    const int m_channels;
+    const int m_bytesPerFrame;
+    std::atomic<float> m_volume;
+
+    // Request written by the worker; the serial is odd while it changes
+    std::atomic<quint32> m_requestSerial;
+    std::atomic<int> m_requestDeck;
+    std::atomic<quint64> m_requestStart;
+    std::atomic<qsizetype> m_requestLength;
+    std::atomic<int> m_requestCurve;
+    std::atomic<quint32> m_completed;
+
+    // Owned by the audio thread
+    quint32 m_seenSerial;
+    int m_main;
+    bool m_pending;         // m_fade waits for m_main to reach its start
+    bool m_fading;
+    Request m_fade;
+    qsizetype m_faded;      // frames of m_fade done
+    std::unique_ptr<float[]> m_mix;     // a block, before conversion to integers
+    std::unique_ptr<float[]> m_input;   // a block of the deck fading in
+};
+
+#endif // SINKREADER_H
@@ -0,0 +1,67 @@
+#include "splicedfile.h"
+
+SplicedFile::SplicedFile(const QString &filePath, qint64 headerSize, qint64 offset, QObject *parent)
+    : QIODevice(parent)
+    , m_file(filePath)
+    , m_headerSize(headerSize)
+    , m_offset(offset)
+{
+}
+
+bool SplicedFile::open(OpenMode mode)
+{
+    if ((mode & WriteOnly) || m_offset < m_headerSize || !m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    if (m_file.size() < m_offset) {
+        m_file.close();
+        return false;
+    }
+    // Unbuffered, so pos() is always where readData() reads from
+    return QIODevice::open(mode | Unbuffered);
+}
+
+void SplicedFile::close()
+{
+    QIODevice::close();
+    m_file.close();
+}
+
+qint64 SplicedFile::size() const
+{
+    return m_headerSize + m_file.size() - m_offset;
+}
+
+bool SplicedFile::seek(qint64 pos)
+{
+    return pos >= 0 && pos <= size() && QIODevice::seek(pos);
+}
+
+qint64 SplicedFile::readData(char *data, qint64 maxSize)
+{
+    qint64 read = 0;
+    while (read < maxSize) {
+        const qint64 pos = QIODevice::pos() + read;
+        const bool header = pos < m_headerSize;
+        const qint64 available = (header ? m_headerSize : size()) - pos;
+        if (available <= 0) {
+            break;
+        }
+        if (!m_file.seek(header ? pos : m_offset + pos - m_headerSize)) {
+            return read > 0 ? read : -1;
+        }
+        const qint64 count = m_file.read(data + read, qMin(available, maxSize - read));
+        if (count <= 0) {
+            return read > 0 ? read : count;
+        }
+        read += count;
+    }
+    return read;
+}
+
+qint64 SplicedFile::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
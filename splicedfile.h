@@ -0,0 +1,33 @@
+#ifndef SPLICEDFILE_H
+#define SPLICEDFILE_H
+
+#include <QFile>
+#include <QIODevice>
+
+// A file read with a stretch cut out of it: the first headerSize bytes,
+// then everything from offset on. Handed to a decoder, it looks like the
+// file's header followed straight away by the frame at offset, so decoding
+// starts part way in without reading what comes before.
+class SplicedFile : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    SplicedFile(const QString &filePath, qint64 headerSize, qint64 offset, QObject *parent = nullptr);
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    qint64 size() const override;
+    bool seek(qint64 pos) override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    QFile m_file;
+    const qint64 m_headerSize;
+    const qint64 m_offset;
+};
+
+#endif // SPLICEDFILE_H
@@ -0,0 +1,26 @@
+#include "startupclock.h"
+#include "logging.h"
+#include <QElapsedTimer>
+
+namespace StartupClock {
+
+namespace {
+    QElapsedTimer clock;
+}
+
+void start()
+{
+    clock.start();
+}
+
+void report(const char *milestone)
+{
+    const qint64 elapsed = clock.elapsed();
+    if (elapsed > BUDGET) {
+        qCWarning(lcUi) << "Startup:" << milestone << "after" << elapsed << "ms, over the" << BUDGET << "ms budget";
+    } else {
+        qCInfo(lcUi) << "Startup:" << milestone << "after" << elapsed << "ms";
+    }
+}
+
+}
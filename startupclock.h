@@ -0,0 +1,16 @@
+#ifndef STARTUPCLOCK_H
+#define STARTUPCLOCK_H
+
+#include <QtGlobal>
+
+// Times a cold start from the top of main(). The window reports its first
+// frame and the point where everything behind it is built; both are logged
+// to muse.ui, as warnings once they go over the thin-client budget.
+namespace StartupClock {
+    constexpr qint64 BUDGET = 200;  // msecs
+
+    void start();
+    void report(const char *milestone);
+}
+
+#endif // STARTUPCLOCK_H
@@ -0,0 +1,19 @@
+#include "stringpool.h"
+
+int StringPool::intern(const QString &string)
+{
+    const auto it = m_ids.constFind(string);
+    if (it != m_ids.constEnd()) {
+        return it.value();
+    }
+
+    const int id = m_strings.size();
+    m_strings.append(string);
+    m_ids.insert(string, id);
+    return id;
+}
+
+int StringPool::find(const QString &string) const
+{
+    return m_ids.value(string, -1);
+}
@@ -0,0 +1,23 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Interns strings to dense integer ids. Ids are never reused, so the pool
+// only grows by the distinct strings seen during a session.
+class StringPool
+{
+public:
+    int intern(const QString &string);
+    int find(const QString &string) const;  // -1 if not interned
+    const QString &string(int id) const { return m_strings.at(id); }
+    int size() const { return m_strings.size(); }
+
+private:
+    QVector<QString> m_strings;
+    QHash<QString, int> m_ids;
+};
+
+#endif // STRINGPOOL_H
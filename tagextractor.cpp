@@ -0,0 +1,136 @@
+#include "tagextractor.h"
+#include "coverstore.h"
+#include <QMutexLocker>
+#include <QThread>
+
+namespace {
+    constexpr int CHUNK_SIZE = 16;
+    constexpr int FLUSH_INTERVAL_MS = 150;
+}
+
+TagExtractor::TagExtractor(QObject *parent)
+    : QObject(parent)
+    , m_activeWorkers(0)
+    , m_generation(0)
+{
+    // Tag reading is mostly parsing once the data is cached, so one worker
+    // per core
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+
+    m_flushTimer.setInterval(FLUSH_INTERVAL_MS);
+    connect(&m_flushTimer, &QTimer::timeout, this, &TagExtractor::flush);
+}
+
+TagExtractor::~TagExtractor()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_generation;
+        m_queue.clear();
+    }
+    m_pool.waitForDone();
+}
+
+void TagExtractor::enqueue(const QStringList &filePaths)
+{
+    if (filePaths.isEmpty()) {
+        return;
+    }
+
+    int workersToStart = 0;
+    quint64 generation;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queue.append(filePaths);
+        const int wanted = qMin(m_pool.maxThreadCount(), (int(m_queue.size()) + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        workersToStart = qMax(0, wanted - m_activeWorkers);
+        m_activeWorkers += workersToStart;
+        generation = m_generation;
+    }
+
+    for (int i = 0; i < workersToStart; ++i) {
+        m_pool.start([this, generation]() {
+            work(generation);
+        });
+    }
+
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void TagExtractor::cancel()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_generation;
+        m_queue.clear();
+        m_results.clear();
+    }
+    // The flush timer keeps running until busy workers have noticed
+}
+
+bool TagExtractor::isBusy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_queue.isEmpty() || m_activeWorkers > 0 || !m_results.isEmpty();
+}
+
+void TagExtractor::work(quint64 generation)
+{
+    forever {
+        QStringList chunk;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.isEmpty()) {
+                --m_activeWorkers;
+                return;
+            }
+            // A worker that outlived cancel() still counts as active, so
+            // enqueue() may not have started one for the new queue; it
+            // carries on with that queue instead
+            generation = m_generation;
+            const int count = qMin(CHUNK_SIZE, int(m_queue.size()));
+            chunk = m_queue.mid(0, count);
+            m_queue.remove(0, count);
+        }
+
+        QList<TrackInfo> tracks;
+        tracks.reserve(chunk.size());
+        for (const QString &filePath : std::as_const(chunk)) {
+            // Covers are decoded once per distinct hash while the bytes are at hand
+            QByteArray picture;
+            const TrackInfo info = TrackInfo::read(filePath, &picture);
+            if (!picture.isEmpty()) {
+                CoverStore::store(info.artKey(), picture);
+            }
+            tracks.append(info);
+        }
+
+        QMutexLocker locker(&m_mutex);
+        if (generation == m_generation) {
+            m_results.append(tracks);
+        }
+    }
+}
+
+void TagExtractor::flush()
+{
+    QList<TrackInfo> results;
+    bool working;
+    {
+        QMutexLocker locker(&m_mutex);
+        results.swap(m_results);
+        working = !m_queue.isEmpty() || m_activeWorkers > 0;
+    }
+
+    if (!results.isEmpty()) {
+        emit tracksRead(results);
+    }
+
+    // Only enqueue() on this thread can add work, so this cannot go stale
+    if (!working && !isBusy()) {
+        m_flushTimer.stop();
+        emit idle();
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef TAGEXTRACTOR_H
+#define TAGEXTRACTOR_H
+
+#include <QObject>
+#include <QStringList>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include <QTimer>
+#include "trackinfo.h"
+
+// Reads tags on a bounded set of worker threads. Workers pull files from a
+// shared queue in small chunks; results are handed back to the GUI thread
+// in coalesced batches.
+class TagExtractor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TagExtractor(QObject *parent = nullptr);
+    ~TagExtractor();
+
+    void enqueue(const QStringList &filePaths);
+    void cancel();
+    bool isBusy() const;
+
+signals:
+    void tracksRead(const QList<TrackInfo> &tracks);
+    void idle();
+
+private:
+    void work(quint64 generation);
+    void flush();
+
+    QThreadPool m_pool;
+    QTimer m_flushTimer;
+
+    mutable QMutex m_mutex;
+    QStringList m_queue;
+    QList<TrackInfo> m_results;
+    int m_activeWorkers;
+    quint64 m_generation;
+};
+
+#endif // TAGEXTRACTOR_H
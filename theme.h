@@ -73,25 +73,36 @@ namespace Theme {
     ).arg(Colors::Mid, Colors::Button, Colors::Primary);
 
     const QString LIST_WIDGET_STYLE = QString(
-        "QListWidget {"
+        "QListView {"
         "    background-color: %1;"
         "    border: none;"
         "    color: %2;"
         "    font-size: 14px;"
         "}"
-        "QListWidget::item {"
+        "QListView::item {"
         "    padding: 10px;"
         "    border-bottom: 1px solid %3;"
         "}"
-        "QListWidget::item:selected {"
+        "QListView::item:selected {"
         "    background-color: %4;"
         "    color: %5;"
         "}"
-        "QListWidget::item:hover {"
+        "QListView::item:hover {"
         "    background-color: %4;"
         "}"
     ).arg(Colors::Background, Colors::Text, Colors::Mid, Colors::Primary, Colors::HighlightedText);
 
+    const QString SEARCH_BOX_STYLE = QString(
+        "QLineEdit {"
+        "    background-color: %1;"
+        "    color: %2;"
+        "    border: none;"
+        "    border-bottom: 1px solid %3;"
+        "    padding: 8px 10px;"
+        "    font-size: 14px;"
+        "}"
+    ).arg(Colors::Background, Colors::Text, Colors::Mid);
+
     const QString LABEL_STYLE = QString(
         "QLabel {"
         "    color: %1;"
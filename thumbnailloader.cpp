@@ -0,0 +1,167 @@
+#include "thumbnailloader.h"
+#include "albumartcache.h"
+#include "coverstore.h"
+#include "trace.h"
+#include <QMutexLocker>
+#include <QPainter>
+#include <QPainterPath>
+#include <QThread>
+#include <climits>
+
+namespace {
+    constexpr int MIN_PIXMAP_CACHE_KB = 64 * 1024;
+    constexpr int WORKERS = 2;
+    // The largest stored thumbnail; enough for a grid cover at 2x
+    constexpr int SOURCE_SIZE = 300;
+}
+
+ThumbnailLoader::ThumbnailLoader(int size, QObject *parent)
+    : QObject(parent)
+    , m_size(size)
+    , m_ratio(1.0)
+    , m_pixmaps(MIN_PIXMAP_CACHE_KB)
+    , m_activeWorkers(0)
+{
+    m_pool.setMaxThreadCount(WORKERS);
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+ThumbnailLoader::~ThumbnailLoader()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queue.clear();
+    }
+    m_pool.waitForDone();
+}
+
+void ThumbnailLoader::setDevicePixelRatio(qreal ratio)
+{
+    if (!qFuzzyCompare(ratio, m_ratio)) {
+        // Moved to a screen of another density; what is cached is the wrong size
+        QMutexLocker locker(&m_mutex);
+        m_ratio = ratio;
+        m_pixmaps.clear();
+    }
+}
+
+QPixmap ThumbnailLoader::pixmap(const QString &artKey)
+{
+    const QPixmap *cached = m_pixmaps.object(artKey);
+    return cached ? *cached : QPixmap();
+}
+
+void ThumbnailLoader::prioritize(const QList<Cover> &visible, const QList<Cover> &prefetch)
+{
+    // Room for everything asked for and as much again for what was just
+    // scrolled past, so loading the nearby covers never evicts visible ones
+    const int pixels = qRound(m_size * m_ratio);
+    const qint64 coverKB = qint64(pixels) * pixels * 4 / 1024;
+    const qint64 wanted = 2 * (visible.size() + prefetch.size()) * coverKB;
+    m_pixmaps.setMaxCost(int(qBound<qint64>(MIN_PIXMAP_CACHE_KB, wanted, INT_MAX)));
+
+    int workers = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        // Whatever is still queued from the last call has scrolled away;
+        // keys already being rendered stay in m_loading until they finish
+        for (const Cover &cover : std::as_const(m_queue)) {
+            m_loading.remove(cover.artKey);
+        }
+        m_queue.clear();
+
+        for (const QList<Cover> *covers : {&visible, &prefetch}) {
+            for (const Cover &cover : *covers) {
+                const QString &key = cover.artKey;
+                if (key.isEmpty() || m_loading.contains(key) || m_missing.contains(key)
+                        || m_pixmaps.contains(key)) {
+                    continue;
+                }
+                m_queue.append(cover);
+                m_loading.insert(key);
+            }
+        }
+        workers = qMin(int(m_queue.size()), WORKERS - m_activeWorkers);
+        m_activeWorkers += qMax(workers, 0);
+    }
+
+    for (int i = 0; i < workers; ++i) {
+        m_pool.start([this]() {
+            work();
+        });
+    }
+}
+
+void ThumbnailLoader::work()
+{
+    forever {
+        Cover cover;
+        qreal ratio;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.isEmpty()) {
+                --m_activeWorkers;
+                return;
+            }
+            cover = m_queue.takeFirst();
+            ratio = m_ratio;
+        }
+
+        const QImage image = render(cover, ratio);
+        QMetaObject::invokeMethod(this, [this, key = cover.artKey, image, ratio]() {
+            finish(key, image, ratio);
+        }, Qt::QueuedConnection);
+    }
+}
+
+QImage ThumbnailLoader::render(const Cover &cover, qreal ratio) const
+{
+    TRACE_SCOPE("render thumbnail");
+    QImage source = CoverStore::thumbnail(cover.artKey, SOURCE_SIZE);
+    if (source.isNull()) {
+        // From the master, or if the cache was cleared while the index
+        // kept its keys, read from the track and stored again
+        TrackInfo track;
+        track.filePath = cover.filePath;
+        track.artHash = QByteArray::fromHex(cover.artKey.toLatin1());
+        source = AlbumArtCache::decode(track);
+    }
+    if (source.isNull()) {
+        return QImage();
+    }
+
+    // Cropped to a square, scaled once here rather than on every paint
+    const int pixels = qRound(m_size * ratio);
+    const QImage scaled = source.scaled(pixels, pixels, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+
+    QImage image(pixels, pixels, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QPainterPath path;
+    path.addRoundedRect(QRectF(0, 0, pixels, pixels), pixels / 24.0, pixels / 24.0);
+    painter.setClipPath(path);
+    painter.drawImage((pixels - scaled.width()) / 2, (pixels - scaled.height()) / 2, scaled);
+    painter.end();
+
+    image.setDevicePixelRatio(ratio);
+    return image;
+}
+
+void ThumbnailLoader::finish(const QString &artKey, const QImage &image, qreal ratio)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_loading.remove(artKey);
+    }
+    if (!qFuzzyCompare(ratio, m_ratio)) {
+        return;     // rendered for the old screen; asked for again on the next scroll
+    }
+    if (image.isNull()) {
+        m_missing.insert(artKey);
+    } else {
+        m_pixmaps.insert(artKey, new QPixmap(QPixmap::fromImage(image)),
+                         qMax(1, int(image.sizeInBytes() / 1024)));
+    }
+    emit loaded(artKey);
+}
@@ -0,0 +1,61 @@
+#ifndef THUMBNAILLOADER_H
+#define THUMBNAILLOADER_H
+
+#include <QCache>
+#include <QMutex>
+#include <QObject>
+#include <QPixmap>
+#include <QList>
+#include <QSet>
+#include <QThreadPool>
+
+// Cover thumbnails for the album grid, read from the CoverStore, or from
+// the track again if the store has lost them, on a few background threads and kept in memory already scaled and rounded, so a
+// cell paints with one blit. The view says which covers it shows and
+// which are just off screen; those replace whatever was still waiting, on
+// screen first, so a fast scroll drops what has gone by.
+class ThumbnailLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    // A cover and a track that embeds it
+    struct Cover
+    {
+        QString artKey;
+        QString filePath;
+    };
+
+    // size is the side of a cover in device-independent pixels
+    explicit ThumbnailLoader(int size, QObject *parent = nullptr);
+    ~ThumbnailLoader();
+
+    int size() const { return m_size; }
+    void setDevicePixelRatio(qreal ratio);
+
+    // Null until loaded, or if the cover cannot be read
+    QPixmap pixmap(const QString &artKey);
+
+    void prioritize(const QList<Cover> &visible, const QList<Cover> &prefetch);
+
+signals:
+    void loaded(const QString &artKey);
+
+private:
+    void work();
+    QImage render(const Cover &cover, qreal ratio) const;
+    void finish(const QString &artKey, const QImage &image, qreal ratio);
+
+    const int m_size;
+    qreal m_ratio;
+    QCache<QString, QPixmap> m_pixmaps;
+    QSet<QString> m_missing;    // covers that could not be read
+
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QList<Cover> m_queue;
+    QSet<QString> m_loading;    // queued or being rendered
+    int m_activeWorkers;
+};
+
+#endif // THUMBNAILLOADER_H
@@ -0,0 +1,116 @@
+#include "trace.h"
+#include "logging.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QVector>
+
+namespace Trace {
+
+std::atomic<bool> active(false);
+
+namespace {
+    // About 32 MB of events; a trace that long is too big to open anyway
+    constexpr qsizetype MAX_EVENTS = 1 << 20;
+
+    struct Event
+    {
+        const char *name;
+        int thread;
+        qint64 begin;
+        qint64 end;
+    };
+
+    QElapsedTimer clock;
+    QString fileName;
+    QMutex mutex;
+    QVector<Event> events;
+    qsizetype dropped = 0;
+    std::atomic<int> threadCount(0);
+
+    // Small ids in order of first use, so the GUI thread is 1
+    int threadId()
+    {
+        thread_local const int id = ++threadCount;
+        return id;
+    }
+
+    QByteArray micros(qint64 nsecs)
+    {
+        return QByteArray::number(nsecs / 1000.0, 'f', 3);
+    }
+}
+
+void start()
+{
+    fileName = qEnvironmentVariable("MUSE_TRACE");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    threadId();
+    clock.start();
+    active = true;
+    qCInfo(lcTrace) << "Tracing to" << fileName;
+}
+
+void finish()
+{
+    if (!isEnabled()) {
+        return;
+    }
+    active = false;
+
+    QMutexLocker locker(&mutex);
+    if (dropped > 0) {
+        qCWarning(lcTrace) << "Dropped" << dropped << "spans past the first" << MAX_EVENTS;
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcTrace) << "Could not write trace:" << file.errorString();
+        return;
+    }
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray out;
+    out.reserve(events.size() * 96 + 256);
+    out += "{\"traceEvents\":[\n";
+    out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":1,\"args\":{\"name\":\"GUI\"}}";
+    for (const Event &event : std::as_const(events)) {
+        out += ",\n{\"name\":\"";
+        out += event.name;
+        out += "\",\"ph\":\"X\",\"ts\":" + micros(event.begin)
+             + ",\"dur\":" + micros(event.end - event.begin)
+             + ",\"pid\":" + pid
+             + ",\"tid\":" + QByteArray::number(event.thread) + '}';
+    }
+    out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    file.write(out);
+
+    if (!file.commit()) {
+        qCWarning(lcTrace) << "Could not write trace:" << file.errorString();
+        return;
+    }
+    qCInfo(lcTrace) << "Wrote" << events.size() << "spans to" << fileName;
+    events.clear();
+}
+
+qint64 now()
+{
+    return clock.nsecsElapsed();
+}
+
+void record(const char *name, qint64 begin, qint64 end)
+{
+    const int thread = threadId();
+    QMutexLocker locker(&mutex);
+    if (events.size() < MAX_EVENTS) {
+        events.append({ name, thread, begin, end });
+    } else {
+        ++dropped;
+    }
+}
+
+}
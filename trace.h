@@ -0,0 +1,56 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// Scoped spans around the hot paths, for seeing where the time goes.
+// With MUSE_TRACE set to a file name, spans are collected in memory and
+// written there at exit as Chrome trace-event JSON, which chrome://tracing
+// and Perfetto open. Otherwise a span costs a load of one flag.
+//
+//     TRACE_SCOPE("read tags");
+//
+// Names are kept as pointers, so they must be string literals.
+namespace Trace {
+    extern std::atomic<bool> active;
+
+    inline bool isEnabled() { return active.load(std::memory_order_relaxed); }
+
+    // At the top of main(), before any other thread starts
+    void start();
+    // Stops tracing and writes the file
+    void finish();
+
+    qint64 now();   // nsecs since start()
+    void record(const char *name, qint64 begin, qint64 end);
+}
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name)
+        : m_name(Trace::isEnabled() ? name : nullptr)
+        , m_begin(m_name ? Trace::now() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_name) {
+            Trace::record(m_name, m_begin, Trace::now());
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(TraceScope)
+
+    const char *m_name;
+    qint64 m_begin;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // TRACE_H
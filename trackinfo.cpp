@@ -0,0 +1,155 @@
+#include "trackinfo.h"
+#include "trace.h"
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QDateTime>
+#include <taglib/fileref.h>
+#include <taglib/tag.h>
+#include <taglib/audioproperties.h>
+#include <taglib/tpropertymap.h>
+#include <taglib/mpegfile.h>
+#include <taglib/flacfile.h>
+#include <taglib/mp4file.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/attachedpictureframe.h>
+#include <taglib/flacpicture.h>
+#include <taglib/mp4coverart.h>
+
+namespace {
+    TagLib::ByteVector embeddedPicture(TagLib::File *file)
+    {
+        // Try to get the cover art based on file type
+        if (TagLib::MPEG::File *mpegFile = dynamic_cast<TagLib::MPEG::File*>(file)) {
+            if (mpegFile->ID3v2Tag()) {
+                TagLib::ID3v2::FrameList frames = mpegFile->ID3v2Tag()->frameList("APIC");
+                if (!frames.isEmpty()) {
+                    TagLib::ID3v2::AttachedPictureFrame *frame =
+                        dynamic_cast<TagLib::ID3v2::AttachedPictureFrame*>(frames.front());
+                    if (frame) {
+                        return frame->picture();
+                    }
+                }
+            }
+        }
+        else if (TagLib::FLAC::File *flacFile = dynamic_cast<TagLib::FLAC::File*>(file)) {
+            const TagLib::List<TagLib::FLAC::Picture*>& pictures = flacFile->pictureList();
+            if (!pictures.isEmpty()) {
+                return pictures.front()->data();
+            }
+        }
+        else if (TagLib::MP4::File *mp4File = dynamic_cast<TagLib::MP4::File*>(file)) {
+            TagLib::MP4::Tag *mp4Tag = mp4File->tag();
+            if (mp4Tag) {
+                const TagLib::MP4::ItemMap& itemsMap = mp4Tag->itemMap();
+                if (itemsMap.contains("covr")) {
+                    const TagLib::MP4::CoverArtList& coverArtList =
+                        itemsMap["covr"].toCoverArtList();
+                    if (!coverArtList.isEmpty()) {
+                        return coverArtList[0].data();
+                    }
+                }
+            }
+        }
+        return TagLib::ByteVector();
+    }
+}
+
+TrackInfo TrackInfo::read(const QString &filePath, QByteArray *picture)
+{
+    TRACE_SCOPE("read tags");
+    TrackInfo info;
+    info.filePath = filePath;
+
+    QFileInfo fileInfo(filePath);
+    info.size = fileInfo.size();
+    info.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    TagLib::FileRef file(filePath.toUtf8().constData());
+    if (!file.isNull()) {
+        TagLib::Tag *tag = file.tag();
+        if (tag) {
+            info.hasTags = true;
+            info.title = QString::fromStdString(tag->title().toCString(true));
+            info.artist = QString::fromStdString(tag->artist().toCString(true));
+            info.album = QString::fromStdString(tag->album().toCString(true));
+            info.genre = QString::fromStdString(tag->genre().toCString(true));
+            info.trackNumber = quint16(qMin(tag->track(), 0xffffu));
+        }
+
+        // Parsed along with the tags anyway, so it costs nothing extra
+        if (const TagLib::AudioProperties *properties = file.audioProperties()) {
+            info.audio.duration = properties->lengthInMilliseconds();
+            info.audio.bitrate = properties->bitrate();
+            info.audio.sampleRate = properties->sampleRate();
+            info.audio.channels = properties->channels();
+        }
+
+        // Album artist has no slot in the basic tag; every format maps it here
+        const TagLib::PropertyMap properties = file.file()->properties();
+        const auto albumArtist = properties.find("ALBUMARTIST");
+        if (albumArtist != properties.end() && !albumArtist->second.isEmpty()) {
+            info.albumArtist = QString::fromStdString(albumArtist->second.front().toCString(true));
+        }
+        // Often written as "1/2"
+        const auto discNumber = properties.find("DISCNUMBER");
+        if (discNumber != properties.end() && !discNumber->second.isEmpty()) {
+            const QString disc = QString::fromStdString(discNumber->second.front().toCString(true));
+            info.discNumber = quint16(qBound(0, disc.section(QLatin1Char('/'), 0, 0).trimmed().toInt(), 0xffff));
+        }
+
+        // Hash the cover while the file is open so identical covers across
+        // an album resolve to one cache entry
+        const TagLib::ByteVector data = embeddedPicture(file.file());
+        if (!data.isEmpty()) {
+            const QByteArray bytes = QByteArray::fromRawData(data.data(), int(data.size()));
+            info.artHash = QCryptographicHash::hash(bytes, QCryptographicHash::Md5);
+            if (picture) {
+                *picture = QByteArray(bytes.constData(), bytes.size());
+            }
+        }
+    }
+
+    return info;
+}
+
+QDataStream &operator<<(QDataStream &out, const Loudness &loudness)
+{
+    out << loudness.integrated << loudness.truePeak;
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, Loudness &loudness)
+{
+    in >> loudness.integrated >> loudness.truePeak;
+    return in;
+}
+
+QDataStream &operator<<(QDataStream &out, const AudioProperties &audio)
+{
+    out << audio.duration << audio.bitrate << audio.sampleRate << audio.channels;
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, AudioProperties &audio)
+{
+    in >> audio.duration >> audio.bitrate >> audio.sampleRate >> audio.channels;
+    return in;
+}
+
+QDataStream &operator<<(QDataStream &out, const TrackInfo &info)
+{
+    out << info.filePath << info.size << info.modified << info.hasTags
+        << info.title << info.artist << info.albumArtist << info.album << info.genre
+        << info.discNumber << info.trackNumber << info.audio << info.artHash
+        << info.loudness.track << info.loudness.album;
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, TrackInfo &info)
+{
+    in >> info.filePath >> info.size >> info.modified >> info.hasTags
+       >> info.title >> info.artist >> info.albumArtist >> info.album >> info.genre
+       >> info.discNumber >> info.trackNumber >> info.audio >> info.artHash
+       >> info.loudness.track >> info.loudness.album;
+    return in;
+}
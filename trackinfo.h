@@ -0,0 +1,72 @@
+#ifndef TRACKINFO_H
+#define TRACKINFO_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDataStream>
+
+// EBU R128 integrated loudness and true peak, from LoudnessAnalyzer
+struct Loudness
+{
+    float integrated = 0;   // LUFS, -infinity for silence
+    float truePeak = -1;    // linear, negative until measured
+    bool isValid() const { return truePeak >= 0; }
+};
+
+// What ReplayGain needs of a track: its own loudness and its album's,
+// measured over all of the album's tracks together
+struct LoudnessInfo
+{
+    Loudness track;
+    Loudness album;
+};
+
+// The stream as TagLib sees it while reading the tags
+struct AudioProperties
+{
+    qint32 duration = 0;    // msecs
+    qint32 bitrate = 0;     // kbit/s
+    qint32 sampleRate = 0;  // Hz
+    qint32 channels = 0;
+};
+
+// Tags, audio properties and file identity for a single track, as stored
+// in the library index. Read once per file version; everything else
+// looks the record up instead of opening the file again
+struct TrackInfo
+{
+    QString filePath;
+    qint64 size = -1;
+    qint64 modified = 0;    // msecs since epoch
+    bool hasTags = false;   // false if TagLib could not read the file
+    QString title;
+    QString artist;
+    QString albumArtist;
+    QString album;
+    QString genre;
+    quint16 discNumber = 0;     // zero if untagged
+    quint16 trackNumber = 0;
+    AudioProperties audio;  // zero if TagLib could not read the stream
+    QByteArray artHash;     // MD5 of the embedded picture, empty if none
+    LoudnessInfo loudness;  // left unmeasured by read()
+
+    bool isValid() const { return !filePath.isEmpty(); }
+    bool matches(qint64 fileSize, qint64 fileModified) const
+    {
+        return size == fileSize && modified == fileModified;
+    }
+    QString artKey() const { return QString::fromLatin1(artHash.toHex()); }
+
+    // Reads tags and audio properties and hashes the embedded picture in
+    // one pass; the picture bytes are only copied out if picture is non-null
+    static TrackInfo read(const QString &filePath, QByteArray *picture = nullptr);
+};
+
+QDataStream &operator<<(QDataStream &out, const Loudness &loudness);
+QDataStream &operator>>(QDataStream &in, Loudness &loudness);
+QDataStream &operator<<(QDataStream &out, const AudioProperties &audio);
+QDataStream &operator>>(QDataStream &in, AudioProperties &audio);
+QDataStream &operator<<(QDataStream &out, const TrackInfo &info);
+QDataStream &operator>>(QDataStream &in, TrackInfo &info);
+
+#endif // TRACKINFO_H
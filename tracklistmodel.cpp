@@ -0,0 +1,108 @@
+#include "tracklistmodel.h"
+#include "trace.h"
+#include <QSet>
+
+TrackListModel::TrackListModel(TrackStore *store, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_store(store)
+{
+    connect(m_store, &TrackStore::tracksAboutToBeRemoved, this, &TrackListModel::onTracksAboutToBeRemoved);
+    connect(m_store, &TrackStore::tracksChanged, this, &TrackListModel::onTracksChanged);
+}
+
+void TrackListModel::setTracks(const QVector<int> &ids)
+{
+    TRACE_SCOPE("set track list");
+    beginResetModel();
+    m_ids = ids;
+    endResetModel();
+}
+
+const QVector<int> &TrackListModel::tracks() const
+{
+    return m_ids;
+}
+
+QString TrackListModel::filePath(int row) const
+{
+    if (row < 0 || row >= m_ids.size()) {
+        return QString();
+    }
+    return m_store->filePath(m_ids.at(row));
+}
+
+int TrackListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_ids.size();
+}
+
+QVariant TrackListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_ids.size()) {
+        return QVariant();
+    }
+
+    const int id = m_ids.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return m_store->fileName(id);
+    case FilePathRole:
+        return m_store->filePath(id);
+    case TitleRole:
+        return m_store->title(id);
+    case ArtistRole:
+        return m_store->artist(id);
+    case AlbumRole:
+        return m_store->album(id);
+    case DurationRole:
+        return m_store->audio(id).duration;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> TrackListModel::roleNames() const
+{
+    return {
+        { Qt::DisplayRole, "fileName" },
+        { FilePathRole, "filePath" },
+        { TitleRole, "title" },
+        { ArtistRole, "artist" },
+        { AlbumRole, "album" },
+        { DurationRole, "duration" }
+    };
+}
+
+void TrackListModel::onTracksAboutToBeRemoved(const QVector<int> &ids)
+{
+    if (m_ids.isEmpty()) {
+        return;
+    }
+
+    // Remove matching rows in contiguous runs, back to front
+    const QSet<int> removed(ids.cbegin(), ids.cend());
+    int row = m_ids.size();
+    while (row > 0) {
+        if (!removed.contains(m_ids.at(row - 1))) {
+            --row;
+            continue;
+        }
+        int first = row - 1;
+        while (first > 0 && removed.contains(m_ids.at(first - 1))) {
+            --first;
+        }
+
+        beginRemoveRows(QModelIndex(), first, row - 1);
+        m_ids.remove(first, row - first);
+        endRemoveRows();
+        row = first;
+    }
+}
+
+void TrackListModel::onTracksChanged()
+{
+    // The view only repaints what is visible, so the whole range is cheap
+    if (!m_ids.isEmpty()) {
+        emit dataChanged(index(0), index(m_ids.size() - 1));
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef TRACKLISTMODEL_H
+#define TRACKLISTMODEL_H
+
+#include <QAbstractListModel>
+#include "trackstore.h"
+
+// A list of track ids from the store. Rows only hold the id; everything
+// shown is looked up when the view asks for it.
+class TrackListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        FilePathRole = Qt::UserRole,
+        TitleRole,
+        ArtistRole,
+        AlbumRole,
+        DurationRole    // msecs
+    };
+
+    explicit TrackListModel(TrackStore *store, QObject *parent = nullptr);
+
+    void setTracks(const QVector<int> &ids);
+    const QVector<int> &tracks() const;
+    QString filePath(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+private slots:
+    void onTracksAboutToBeRemoved(const QVector<int> &ids);
+    void onTracksChanged();
+
+private:
+    TrackStore *m_store;
+    QVector<int> m_ids;
+};
+
+#endif // TRACKLISTMODEL_H
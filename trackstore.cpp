@@ -0,0 +1,776 @@
+#include "trackstore.h"
+#include "trace.h"
+#include <QBitArray>
+#include <QSet>
+#include <algorithm>
+
+namespace {
+    constexpr int EMPTY_STRING = 0;     // interned first in every pool
+    constexpr qsizetype MIN_GARBAGE = 1 << 20;
+    constexpr quint64 NO_GROUP = ~quint64(0);
+
+    int compareNames(QStringView a, QStringView b)
+    {
+        const int result = a.compare(b, Qt::CaseInsensitive);
+        return result != 0 ? result : a.compare(b);
+    }
+
+    template <typename T>
+    int takeSlot(QVector<T> &slots, QVector<int> &freeSlots)
+    {
+        if (!freeSlots.isEmpty()) {
+            return freeSlots.takeLast();
+        }
+        slots.append(T());
+        return slots.size() - 1;
+    }
+
+    // Inserts ids into the sorted order. Ids landing between the same two
+    // neighbours form one run of rows; runs go in back to front so earlier
+    // rows stay valid, with begin/end called around each.
+    template <typename Less, typename Begin, typename End>
+    void insertRuns(QVector<int> &order, QVector<int> ids, Less less, Begin begin, End end)
+    {
+        std::sort(ids.begin(), ids.end(), less);
+        const auto rowFor = [&order, &less](int id) {
+            return int(std::lower_bound(order.cbegin(), order.cend(), id, less) - order.cbegin());
+        };
+
+        int last = ids.size();
+        while (last > 0) {
+            const int row = rowFor(ids.at(last - 1));
+            int first = last - 1;
+            while (first > 0 && rowFor(ids.at(first - 1)) == row) {
+                --first;
+            }
+
+            begin(row, row + last - first - 1);
+            order.insert(row, last - first, 0);
+            std::copy(ids.cbegin() + first, ids.cbegin() + last, order.begin() + row);
+            end();
+            last = first;
+        }
+    }
+
+    // Removes ids from the order in contiguous runs, back to front
+    template <typename Begin, typename End>
+    void removeRuns(QVector<int> &order, const QSet<int> &ids, Begin begin, End end)
+    {
+        int row = order.size();
+        while (row > 0) {
+            if (!ids.contains(order.at(row - 1))) {
+                --row;
+                continue;
+            }
+            int first = row - 1;
+            while (first > 0 && ids.contains(order.at(first - 1))) {
+                --first;
+            }
+
+            begin(first, row - 1);
+            order.remove(first, row - first);
+            end();
+            row = first;
+        }
+    }
+}
+
+TrackStore::TrackStore(QObject *parent)
+    : QObject(parent)
+    , m_textGarbage(0)
+{
+    m_directories.intern(QString());
+    m_names.intern(QString());
+    m_artKeys.intern(QString());
+    m_unknownArtist = m_names.intern(QStringLiteral("Unknown Artist"));
+    m_unknownAlbum = m_names.intern(QStringLiteral("Unknown Album"));
+}
+
+int TrackStore::trackCount() const
+{
+    return m_flags.size() - m_freeIds.size();
+}
+
+int TrackStore::idLimit() const
+{
+    return m_flags.size();
+}
+
+bool TrackStore::contains(int id) const
+{
+    return id >= 0 && id < m_flags.size() && (m_flags.at(id) & Live);
+}
+
+int TrackStore::trackId(const QString &filePath) const
+{
+    const size_t hash = qHash(filePath);
+    for (auto it = m_pathIds.constFind(hash); it != m_pathIds.constEnd() && it.key() == hash; ++it) {
+        if (hasPath(it.value(), filePath)) {
+            return it.value();
+        }
+    }
+    return -1;
+}
+
+bool TrackStore::matches(int id, qint64 size, qint64 modified) const
+{
+    return m_size.at(id) == size && m_modified.at(id) == modified;
+}
+
+QString TrackStore::filePath(int id) const
+{
+    QString path = m_directories.string(m_directory.at(id));
+    path.append(nameView(id));
+    return path;
+}
+
+QString TrackStore::fileName(int id) const
+{
+    return nameView(id).toString();
+}
+
+QString TrackStore::title(int id) const
+{
+    return titleView(id).toString();
+}
+
+const QString &TrackStore::artist(int id) const
+{
+    return m_names.string(m_artist.at(id));
+}
+
+const QString &TrackStore::albumArtist(int id) const
+{
+    return m_names.string(m_albumArtist.at(id));
+}
+
+const QString &TrackStore::album(int id) const
+{
+    return m_names.string(m_album.at(id));
+}
+
+const QString &TrackStore::genre(int id) const
+{
+    return m_names.string(m_genre.at(id));
+}
+
+const QString &TrackStore::artKey(int id) const
+{
+    return m_artKeys.string(m_art.at(id));
+}
+
+const LoudnessInfo &TrackStore::loudness(int id) const
+{
+    return m_loudness.at(id);
+}
+
+const AudioProperties &TrackStore::audio(int id) const
+{
+    return m_audio.at(id);
+}
+
+int TrackStore::discNumber(int id) const
+{
+    return int(m_position.at(id) >> 16);
+}
+
+int TrackStore::trackNumber(int id) const
+{
+    return int(m_position.at(id) & 0xffff);
+}
+
+int TrackStore::trackAlbum(int id) const
+{
+    return m_trackAlbum.at(id);
+}
+
+TrackInfo TrackStore::track(int id) const
+{
+    TrackInfo info;
+    info.filePath = filePath(id);
+    info.size = m_size.at(id);
+    info.modified = m_modified.at(id);
+    info.hasTags = m_flags.at(id) & HasTags;
+    info.title = title(id);
+    info.artist = artist(id);
+    info.albumArtist = albumArtist(id);
+    info.album = album(id);
+    info.genre = genre(id);
+    info.discNumber = quint16(discNumber(id));
+    info.trackNumber = quint16(trackNumber(id));
+    info.audio = m_audio.at(id);
+    info.artHash = QByteArray::fromHex(artKey(id).toLatin1());
+    info.loudness = m_loudness.at(id);
+    return info;
+}
+
+int TrackStore::nameCount() const
+{
+    return m_names.size();
+}
+
+const QString &TrackStore::name(int nameId) const
+{
+    return m_names.string(nameId);
+}
+
+QVector<int> TrackStore::tracksWithNames(const QVector<int> &names) const
+{
+    QBitArray mask(m_names.size());
+    for (int nameId : names) {
+        mask.setBit(nameId);
+    }
+
+    // An album can be reached by both its artist and its title, and its
+    // group artist need not be every track's
+    QVector<int> ids;
+    const auto collect = [this, &mask, &ids](int albumId) {
+        for (int id : m_albums.at(albumId).tracks) {
+            if (mask.testBit(m_artist.at(id)) || mask.testBit(m_albumArtist.at(id))
+                    || mask.testBit(m_album.at(id))) {
+                ids.append(id);
+            }
+        }
+    };
+    for (int nameId : names) {
+        const int artistId = m_artistIds.value(nameId, -1);
+        if (artistId >= 0) {
+            for (int albumId : m_artists.at(artistId).albums) {
+                collect(albumId);
+            }
+        }
+        for (auto it = m_titleAlbums.constFind(nameId); it != m_titleAlbums.cend() && it.key() == nameId; ++it) {
+            collect(it.value());
+        }
+        for (auto it = m_featured.constFind(nameId); it != m_featured.cend() && it.key() == nameId; ++it) {
+            ids.append(it.value());
+        }
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+QStringList TrackStore::filePaths() const
+{
+    QStringList paths;
+    paths.reserve(trackCount());
+    for (int id = 0; id < m_flags.size(); ++id) {
+        if (m_flags.at(id) & Live) {
+            paths.append(filePath(id));
+        }
+    }
+    return paths;
+}
+
+QVector<int> TrackStore::tracksInDirectory(const QString &dir, bool recursive) const
+{
+    // Match against the few distinct directories, then sweep one column
+    const QString prefix = dir.endsWith(QLatin1Char('/')) ? dir : dir + QLatin1Char('/');
+    QVector<bool> wanted(m_directories.size(), false);
+    bool any = false;
+    for (int i = 0; i < m_directories.size(); ++i) {
+        const QString &candidate = m_directories.string(i);
+        if (recursive ? candidate.startsWith(prefix) : candidate == prefix) {
+            wanted[i] = true;
+            any = true;
+        }
+    }
+
+    QVector<int> ids;
+    if (!any) {
+        return ids;
+    }
+    for (int id = 0; id < m_flags.size(); ++id) {
+        if ((m_flags.at(id) & Live) && wanted.at(m_directory.at(id))) {
+            ids.append(id);
+        }
+    }
+    return ids;
+}
+
+int TrackStore::albumCount() const
+{
+    return m_albumOrder.size();
+}
+
+int TrackStore::albumAt(int row) const
+{
+    return m_albumOrder.at(row);
+}
+
+int TrackStore::albumRow(int albumId) const
+{
+    const auto less = [this](int a, int b) { return albumLessThan(a, b); };
+    const auto it = std::lower_bound(m_albumOrder.cbegin(), m_albumOrder.cend(), albumId, less);
+    return it != m_albumOrder.cend() && *it == albumId ? int(it - m_albumOrder.cbegin()) : -1;
+}
+
+const QString &TrackStore::albumTitle(int albumId) const
+{
+    return m_names.string(m_albums.at(albumId).title);
+}
+
+const QString &TrackStore::albumArtistName(int albumId) const
+{
+    return artistName(m_albums.at(albumId).artist);
+}
+
+const QVector<int> &TrackStore::albumTracks(int albumId) const
+{
+    return m_albums.at(albumId).tracks;
+}
+
+int TrackStore::artistCount() const
+{
+    return m_artistOrder.size();
+}
+
+int TrackStore::artistAt(int row) const
+{
+    return m_artistOrder.at(row);
+}
+
+int TrackStore::artistRow(int artistId) const
+{
+    const auto less = [this](int a, int b) { return artistLessThan(a, b); };
+    const auto it = std::lower_bound(m_artistOrder.cbegin(), m_artistOrder.cend(), artistId, less);
+    return it != m_artistOrder.cend() && *it == artistId ? int(it - m_artistOrder.cbegin()) : -1;
+}
+
+const QString &TrackStore::artistName(int artistId) const
+{
+    return m_names.string(m_artists.at(artistId).name);
+}
+
+const QVector<int> &TrackStore::artistAlbums(int artistId) const
+{
+    return m_artists.at(artistId).albums;
+}
+
+void TrackStore::insert(const QList<TrackInfo> &tracks)
+{
+    TRACE_SCOPE("insert tracks");
+    QVector<int> added;
+    QVector<int> changed;
+    QList<TrackInfo> replacements;
+
+    for (const TrackInfo &info : tracks) {
+        const int existing = trackId(info.filePath);
+        if (existing >= 0) {
+            changed.append(existing);
+            replacements.append(info);
+            continue;
+        }
+
+        const int id = allocate();
+        assign(id, info);
+        m_pathIds.insert(qHash(info.filePath), id);
+        added.append(id);
+    }
+
+    // Tags may have moved a changed track to another album
+    QVector<int> moved;
+    QVector<int> stayed;
+    for (int i = 0; i < changed.size(); ++i) {
+        if (groupKey(replacements.at(i)) != groupKey(changed.at(i))) {
+            moved.append(changed.at(i));
+        } else {
+            stayed.append(changed.at(i));
+        }
+    }
+    if (!changed.isEmpty()) {
+        emit tracksAboutToChange(changed);
+    }
+    detach(moved);
+    for (int i = 0; i < changed.size(); ++i) {
+        const int id = changed.at(i);
+        m_textGarbage += m_nameLength.at(id) + m_titleLength.at(id);
+        assign(id, replacements.at(i));
+    }
+
+    // The rest keep their album but may have new numbers or covers
+    QSet<int> retagged;
+    for (int id : std::as_const(stayed)) {
+        if (m_trackAlbum.at(id) >= 0) {
+            retagged.insert(m_trackAlbum.at(id));
+        }
+    }
+    for (int albumId : std::as_const(retagged)) {
+        sortTracks(albumId);
+    }
+    if (!retagged.isEmpty()) {
+        emit albumsChanged(QVector<int>(retagged.cbegin(), retagged.cend()));
+    }
+    QVector<int> inserted = added;
+    added.append(moved);
+
+    attach(added);
+    if (!inserted.isEmpty()) {
+        emit tracksInserted(inserted);
+    }
+    if (!changed.isEmpty()) {
+        emit tracksChanged(changed);
+    }
+    compactText();
+}
+
+void TrackStore::remove(const QStringList &filePaths)
+{
+    QVector<int> ids;
+    QSet<int> seen;
+    for (const QString &filePath : filePaths) {
+        const int id = trackId(filePath);
+        if (id >= 0 && !seen.contains(id)) {
+            seen.insert(id);
+            ids.append(id);
+        }
+    }
+    if (ids.isEmpty()) {
+        return;
+    }
+
+    emit tracksAboutToBeRemoved(ids);
+    detach(ids);
+    for (int id : std::as_const(ids)) {
+        m_pathIds.remove(qHash(filePath(id)), id);
+        release(id);
+    }
+    compactText();
+}
+
+void TrackStore::setLoudness(int id, const LoudnessInfo &loudness)
+{
+    m_loudness[id] = loudness;
+}
+
+int TrackStore::allocate()
+{
+    if (!m_freeIds.isEmpty()) {
+        return m_freeIds.takeLast();
+    }
+
+    const int id = m_flags.size();
+    m_flags.append(0);
+    m_directory.append(EMPTY_STRING);
+    m_artist.append(EMPTY_STRING);
+    m_albumArtist.append(EMPTY_STRING);
+    m_album.append(EMPTY_STRING);
+    m_genre.append(EMPTY_STRING);
+    m_art.append(EMPTY_STRING);
+    m_trackAlbum.append(-1);
+    m_position.append(0);
+    m_size.append(-1);
+    m_modified.append(0);
+    m_textOffset.append(0);
+    m_nameLength.append(0);
+    m_titleLength.append(0);
+    m_loudness.append(LoudnessInfo());
+    m_audio.append(AudioProperties());
+    return id;
+}
+
+void TrackStore::release(int id)
+{
+    unfeature(id);
+    m_textGarbage += m_nameLength.at(id) + m_titleLength.at(id);
+    m_flags[id] = 0;
+    m_trackAlbum[id] = -1;
+    m_nameLength[id] = 0;
+    m_titleLength[id] = 0;
+    m_freeIds.append(id);
+}
+
+void TrackStore::assign(int id, const TrackInfo &info)
+{
+    const qsizetype slash = info.filePath.lastIndexOf(QLatin1Char('/'));
+    const QStringView name = QStringView(info.filePath).mid(slash + 1);
+    const QStringView title = QStringView(info.title).left(0xffff);
+
+    if (m_flags.at(id) & Live) {
+        unfeature(id);
+    }
+    m_flags[id] = info.hasTags ? quint8(Live | HasTags) : quint8(Live);
+    m_directory[id] = m_directories.intern(info.filePath.left(slash + 1));
+    m_artist[id] = m_names.intern(info.artist);
+    m_albumArtist[id] = m_names.intern(info.albumArtist);
+    m_album[id] = m_names.intern(info.album);
+    m_genre[id] = m_names.intern(info.genre);
+    m_position[id] = (quint32(info.discNumber) << 16) | info.trackNumber;
+    m_art[id] = m_artKeys.intern(info.artKey());
+    m_size[id] = info.size;
+    m_modified[id] = info.modified;
+    m_textOffset[id] = quint32(m_text.size());
+    m_nameLength[id] = quint16(qMin<qsizetype>(name.size(), 0xffff));
+    m_titleLength[id] = quint16(title.size());
+    m_loudness[id] = info.loudness;
+    m_audio[id] = info.audio;
+    m_text.append(name.left(m_nameLength.at(id)));
+    m_text.append(title);
+
+    // Only these tracks are out of reach of their artist's albums
+    if (m_albumArtist.at(id) != EMPTY_STRING && m_artist.at(id) != EMPTY_STRING
+            && m_artist.at(id) != m_albumArtist.at(id)) {
+        m_featured.insert(m_artist.at(id), id);
+    }
+}
+
+void TrackStore::unfeature(int id)
+{
+    m_featured.remove(m_artist.at(id), id);
+}
+
+QStringView TrackStore::nameView(int id) const
+{
+    return QStringView(m_text).mid(m_textOffset.at(id), m_nameLength.at(id));
+}
+
+QStringView TrackStore::titleView(int id) const
+{
+    return QStringView(m_text).mid(m_textOffset.at(id) + m_nameLength.at(id), m_titleLength.at(id));
+}
+
+bool TrackStore::hasPath(int id, const QString &filePath) const
+{
+    const QString &dir = m_directories.string(m_directory.at(id));
+    const QStringView name = nameView(id);
+    return filePath.size() == dir.size() + name.size()
+        && filePath.startsWith(dir)
+        && QStringView(filePath).mid(dir.size()) == name;
+}
+
+void TrackStore::compactText()
+{
+    // Replaced and removed text is left in place until it dominates
+    if (m_textGarbage < MIN_GARBAGE || m_textGarbage < m_text.size() / 2) {
+        return;
+    }
+
+    QString text;
+    text.reserve(m_text.size() - m_textGarbage);
+    for (int id = 0; id < m_flags.size(); ++id) {
+        if (!(m_flags.at(id) & Live)) {
+            continue;
+        }
+        const quint32 offset = quint32(text.size());
+        text.append(QStringView(m_text).mid(m_textOffset.at(id), m_nameLength.at(id) + m_titleLength.at(id)));
+        m_textOffset[id] = offset;
+    }
+    m_text = text;
+    m_textGarbage = 0;
+}
+
+quint64 TrackStore::groupKey(const TrackInfo &info)
+{
+    if (!info.hasTags) {
+        return NO_GROUP;
+    }
+
+    int artist = m_unknownArtist;
+    if (!info.albumArtist.isEmpty()) {
+        artist = m_names.intern(info.albumArtist);
+    } else if (!info.artist.isEmpty()) {
+        artist = m_names.intern(info.artist);
+    }
+    const int title = info.album.isEmpty() ? m_unknownAlbum : m_names.intern(info.album);
+    return (quint64(artist) << 32) | quint32(title);
+}
+
+quint64 TrackStore::groupKey(int id) const
+{
+    if (!(m_flags.at(id) & HasTags)) {
+        return NO_GROUP;
+    }
+
+    int artist = m_albumArtist.at(id);
+    if (artist == EMPTY_STRING) {
+        artist = m_artist.at(id);
+    }
+    if (artist == EMPTY_STRING) {
+        artist = m_unknownArtist;
+    }
+    const int title = m_album.at(id) == EMPTY_STRING ? m_unknownAlbum : m_album.at(id);
+    return (quint64(artist) << 32) | quint32(title);
+}
+
+quint64 TrackStore::albumKey(int albumId) const
+{
+    const Album &album = m_albums.at(albumId);
+    return (quint64(m_artists.at(album.artist).name) << 32) | quint32(album.title);
+}
+
+bool TrackStore::albumLessThan(int a, int b) const
+{
+    const Album &first = m_albums.at(a);
+    const Album &second = m_albums.at(b);
+    const int result = compareNames(m_names.string(first.title), m_names.string(second.title));
+    if (result != 0) {
+        return result < 0;
+    }
+    return compareNames(artistName(first.artist), artistName(second.artist)) < 0;
+}
+
+bool TrackStore::artistLessThan(int a, int b) const
+{
+    return compareNames(artistName(a), artistName(b)) < 0;
+}
+
+bool TrackStore::trackLessThan(int a, int b) const
+{
+    if (m_position.at(a) != m_position.at(b)) {
+        return m_position.at(a) < m_position.at(b);
+    }
+    const int result = compareNames(nameView(a), nameView(b));
+    return result != 0 ? result < 0 : a < b;
+}
+
+void TrackStore::sortTracks(int albumId)
+{
+    QVector<int> &tracks = m_albums[albumId].tracks;
+    std::sort(tracks.begin(), tracks.end(), [this](int a, int b) { return trackLessThan(a, b); });
+}
+
+void TrackStore::attach(const QVector<int> &ids)
+{
+    QVector<int> newAlbums;
+    QVector<int> newArtists;
+    QSet<int> grownAlbums;
+    QSet<int> grownArtists;
+    const auto albumLess = [this](int a, int b) { return albumLessThan(a, b); };
+    const auto artistLess = [this](int a, int b) { return artistLessThan(a, b); };
+    const auto trackLess = [this](int a, int b) { return trackLessThan(a, b); };
+
+    for (int id : ids) {
+        const quint64 key = groupKey(id);
+        if (key == NO_GROUP) {
+            m_trackAlbum[id] = -1;
+            continue;
+        }
+
+        int albumId = m_albumIds.value(key, -1);
+        if (albumId < 0) {
+            const int artistName = int(key >> 32);
+            int artistId = m_artistIds.value(artistName, -1);
+            if (artistId < 0) {
+                artistId = takeSlot(m_artists, m_freeArtists);
+                m_artists[artistId].name = artistName;
+                m_artistIds.insert(artistName, artistId);
+                newArtists.append(artistId);
+            }
+
+            albumId = takeSlot(m_albums, m_freeAlbums);
+            m_albums[albumId].title = int(key & 0xffffffff);
+            m_albums[albumId].artist = artistId;
+            m_albumIds.insert(key, albumId);
+            m_titleAlbums.insert(m_albums.at(albumId).title, albumId);
+            newAlbums.append(albumId);
+
+            QVector<int> &albums = m_artists[artistId].albums;
+            albums.insert(std::lower_bound(albums.begin(), albums.end(), albumId, albumLess), albumId);
+            grownArtists.insert(artistId);
+        }
+
+        QVector<int> &tracks = m_albums[albumId].tracks;
+        tracks.insert(std::upper_bound(tracks.begin(), tracks.end(), id, trackLess), id);
+        m_trackAlbum[id] = albumId;
+        grownAlbums.insert(albumId);
+    }
+
+    insertRuns(m_artistOrder, newArtists, artistLess,
+               [this](int first, int last) { emit artistsAboutToBeInserted(first, last); },
+               [this]() { emit artistsInserted(); });
+    insertRuns(m_albumOrder, newAlbums, albumLess,
+               [this](int first, int last) { emit albumsAboutToBeInserted(first, last); },
+               [this]() { emit albumsInserted(); });
+
+    // New rows already show their final contents
+    for (int artistId : std::as_const(newArtists)) {
+        grownArtists.remove(artistId);
+    }
+    for (int albumId : std::as_const(newAlbums)) {
+        grownAlbums.remove(albumId);
+    }
+    if (!grownArtists.isEmpty()) {
+        emit artistsChanged(QVector<int>(grownArtists.cbegin(), grownArtists.cend()));
+    }
+    if (!grownAlbums.isEmpty()) {
+        emit albumsChanged(QVector<int>(grownAlbums.cbegin(), grownAlbums.cend()));
+    }
+}
+
+void TrackStore::detach(const QVector<int> &ids)
+{
+    QHash<int, QSet<int>> groups;
+    for (int id : ids) {
+        const int albumId = m_trackAlbum.at(id);
+        if (albumId >= 0) {
+            groups[albumId].insert(id);
+            m_trackAlbum[id] = -1;
+        }
+    }
+
+    QSet<int> emptyAlbums;
+    QVector<int> shrunkAlbums;
+    for (auto it = groups.cbegin(); it != groups.cend(); ++it) {
+        const QSet<int> &removed = it.value();
+        QVector<int> &tracks = m_albums[it.key()].tracks;
+        tracks.removeIf([&removed](int id) { return removed.contains(id); });
+        if (tracks.isEmpty()) {
+            emptyAlbums.insert(it.key());
+        } else {
+            shrunkAlbums.append(it.key());
+        }
+    }
+    if (!shrunkAlbums.isEmpty()) {
+        emit albumsChanged(shrunkAlbums);
+    }
+    if (emptyAlbums.isEmpty()) {
+        return;
+    }
+
+    // Artists drop their albums before the rows go, so views of a single
+    // artist already see the new list
+    QSet<int> emptyArtists;
+    QSet<int> shrunkArtists;
+    for (int albumId : std::as_const(emptyAlbums)) {
+        const int artistId = m_albums.at(albumId).artist;
+        QVector<int> &albums = m_artists[artistId].albums;
+        albums.removeOne(albumId);
+        if (albums.isEmpty()) {
+            emptyArtists.insert(artistId);
+        } else {
+            shrunkArtists.insert(artistId);
+        }
+    }
+    for (int artistId : std::as_const(emptyArtists)) {
+        shrunkArtists.remove(artistId);
+    }
+    if (!shrunkArtists.isEmpty()) {
+        emit artistsChanged(QVector<int>(shrunkArtists.cbegin(), shrunkArtists.cend()));
+    }
+
+    removeRuns(m_albumOrder, emptyAlbums,
+               [this](int first, int last) { emit albumsAboutToBeRemoved(first, last); },
+               [this]() { emit albumsRemoved(); });
+
+    for (int albumId : std::as_const(emptyAlbums)) {
+        m_albumIds.remove(albumKey(albumId));
+        m_titleAlbums.remove(m_albums.at(albumId).title, albumId);
+        m_albums[albumId] = Album();
+        m_freeAlbums.append(albumId);
+    }
+    if (emptyArtists.isEmpty()) {
+        return;
+    }
+
+    removeRuns(m_artistOrder, emptyArtists,
+               [this](int first, int last) { emit artistsAboutToBeRemoved(first, last); },
+               [this]() { emit artistsRemoved(); });
+
+    for (int artistId : std::as_const(emptyArtists)) {
+        m_artistIds.remove(m_artists.at(artistId).name);
+        m_artists[artistId] = Artist();
+        m_freeArtists.append(artistId);
+    }
+}
@@ -0,0 +1,187 @@
+#ifndef TRACKSTORE_H
+#define TRACKSTORE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMultiHash>
+#include <QStringList>
+#include <QVector>
+#include "stringpool.h"
+#include "trackinfo.h"
+
+// The in-memory track table shared by the library and the list models.
+// Tracks are addressed by stable ids and stored column by column: artist,
+// album, genre, directory and cover are interned ids, and file names and
+// titles are packed into one text arena, so a track costs a few dozen
+// bytes plus its unique strings.
+//
+// On top of the tracks sits an inverted index of artists -> albums ->
+// tracks. An album is keyed by its album artist (falling back to the
+// track artist) and title, so same-named albums by different artists stay
+// apart. Albums and artists also have stable ids, plus a sorted row order
+// for the list models. Only touched from the GUI thread.
+class TrackStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TrackStore(QObject *parent = nullptr);
+
+    int trackCount() const;
+    int idLimit() const;                            // ids are below this
+    bool contains(int id) const;
+    int trackId(const QString &filePath) const;     // -1 if not in the store
+    bool matches(int id, qint64 size, qint64 modified) const;
+
+    QString filePath(int id) const;
+    QString fileName(int id) const;
+    QString title(int id) const;
+    const QString &artist(int id) const;
+    const QString &albumArtist(int id) const;
+    const QString &album(int id) const;
+    const QString &genre(int id) const;
+    const QString &artKey(int id) const;
+    const LoudnessInfo &loudness(int id) const;
+    const AudioProperties &audio(int id) const;
+    int discNumber(int id) const;
+    int trackNumber(int id) const;
+    int trackAlbum(int id) const;                   // album id, -1 if not grouped
+    TrackInfo track(int id) const;
+
+    // Artists, albums and genres share one pool of interned names
+    int nameCount() const;
+    const QString &name(int nameId) const;
+    // Tracks whose artist, album artist or album is one of names, in id
+    // order. Found through the album index, so the cost follows the
+    // number of matches rather than the size of the library
+    QVector<int> tracksWithNames(const QVector<int> &names) const;
+
+    QStringList filePaths() const;
+    // Tracks directly in dir, or anywhere below it if recursive
+    QVector<int> tracksInDirectory(const QString &dir, bool recursive) const;
+
+    // Albums sorted by title, then artist, each with its tracks sorted
+    // by disc and track number, then file name
+    int albumCount() const;
+    int albumAt(int row) const;
+    int albumRow(int albumId) const;
+    const QString &albumTitle(int albumId) const;
+    const QString &albumArtistName(int albumId) const;
+    const QVector<int> &albumTracks(int albumId) const;
+
+    // Artists sorted by name, each with its albums sorted by title
+    int artistCount() const;
+    int artistAt(int row) const;
+    int artistRow(int artistId) const;
+    const QString &artistName(int artistId) const;
+    const QVector<int> &artistAlbums(int artistId) const;
+
+    // Adds new tracks and replaces the ones already present
+    void insert(const QList<TrackInfo> &tracks);
+    void remove(const QStringList &filePaths);
+    // Nothing shows loudness, so this emits no change
+    void setLoudness(int id, const LoudnessInfo &loudness);
+
+signals:
+    // Album and artist rows follow the begin/end protocol of
+    // QAbstractItemModel
+    void albumsAboutToBeInserted(int first, int last);
+    void albumsInserted();
+    void albumsAboutToBeRemoved(int first, int last);
+    void albumsRemoved();
+    void artistsAboutToBeInserted(int first, int last);
+    void artistsInserted();
+    void artistsAboutToBeRemoved(int first, int last);
+    void artistsRemoved();
+    // Rows that stayed but gained, lost or reordered tracks or albums
+    void albumsChanged(const QVector<int> &albumIds);
+    void artistsChanged(const QVector<int> &artistIds);
+
+    void tracksInserted(const QVector<int> &ids);
+    // Emitted while the ids still hold their old values
+    void tracksAboutToBeRemoved(const QVector<int> &ids);
+    void tracksAboutToChange(const QVector<int> &ids);
+    void tracksChanged(const QVector<int> &ids);
+
+private:
+    enum Flag : quint8 {
+        Live = 0x1,
+        HasTags = 0x2
+    };
+
+    struct Album
+    {
+        int title = 0;
+        int artist = -1;    // artist id
+        QVector<int> tracks;
+    };
+
+    struct Artist
+    {
+        int name = 0;
+        QVector<int> albums;
+    };
+
+    int allocate();
+    void release(int id);
+    void assign(int id, const TrackInfo &info);
+    void unfeature(int id);
+    QStringView nameView(int id) const;
+    QStringView titleView(int id) const;
+    bool hasPath(int id, const QString &filePath) const;
+    void compactText();
+
+    quint64 groupKey(const TrackInfo &info);
+    quint64 groupKey(int id) const;
+    quint64 albumKey(int albumId) const;
+    bool albumLessThan(int a, int b) const;
+    bool artistLessThan(int a, int b) const;
+    bool trackLessThan(int a, int b) const;
+    void sortTracks(int albumId);
+    void attach(const QVector<int> &ids);
+    void detach(const QVector<int> &ids);
+
+    // Columns, indexed by track id
+    QVector<quint8> m_flags;
+    QVector<int> m_directory;
+    QVector<int> m_artist;
+    QVector<int> m_albumArtist;
+    QVector<int> m_album;
+    QVector<int> m_genre;
+    QVector<int> m_art;
+    QVector<int> m_trackAlbum;      // album id, -1 if not grouped
+    QVector<quint32> m_position;    // disc number << 16 | track number
+    QVector<qint64> m_size;
+    QVector<qint64> m_modified;
+    QVector<quint32> m_textOffset;  // file name then title in m_text
+    QVector<quint16> m_nameLength;
+    QVector<quint16> m_titleLength;
+    QVector<LoudnessInfo> m_loudness;
+    QVector<AudioProperties> m_audio;
+
+    QString m_text;
+    qsizetype m_textGarbage;
+    QVector<int> m_freeIds;
+    QMultiHash<size_t, int> m_pathIds;  // qHash(filePath) -> id
+
+    StringPool m_directories;   // with trailing slash
+    StringPool m_names;         // artists, albums and genres
+    StringPool m_artKeys;
+    int m_unknownArtist;
+    int m_unknownAlbum;
+
+    // Albums and artists by stable id; freed slots are reused
+    QVector<Album> m_albums;
+    QVector<int> m_freeAlbums;
+    QHash<quint64, int> m_albumIds;     // artist name << 32 | title -> album id
+    QMultiHash<int, int> m_titleAlbums; // title -> album ids
+    QMultiHash<int, int> m_featured;    // artist -> tracks filed under another album artist
+    QVector<int> m_albumOrder;
+    QVector<Artist> m_artists;
+    QVector<int> m_freeArtists;
+    QHash<int, int> m_artistIds;        // name -> artist id
+    QVector<int> m_artistOrder;
+};
+
+#endif // TRACKSTORE_H
@@ -0,0 +1,125 @@
+#include "waveform.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr qsizetype SPAN_FRAMES = 256;
+
+    qint8 toByte(float sample)
+    {
+        return qint8(std::lround(std::clamp(sample, -1.0f, 1.0f) * 127.0f));
+    }
+}
+
+int Waveform::levelFor(int buckets) const
+{
+    for (int level = LEVELS - 1; level > 0; --level) {
+        if (bucketCount(level) >= buckets) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+QDataStream &operator<<(QDataStream &out, const Waveform &waveform)
+{
+    for (const QVector<qint8> &level : waveform.m_levels) {
+        out << level;
+    }
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, Waveform &waveform)
+{
+    // Views index buckets without checking, so the sizes must be exact
+    qsizetype expected = 2 * Waveform::FINEST_BUCKETS;
+    for (QVector<qint8> &level : waveform.m_levels) {
+        in >> level;
+        if (level.size() != expected) {
+            in.setStatus(QDataStream::ReadCorruptData);
+        }
+        expected /= Waveform::REDUCTION;
+    }
+    return in;
+}
+
+WaveformBuilder::WaveformBuilder(int channels)
+    : m_channels(channels)
+    , m_min(0)
+    , m_max(0)
+    , m_fill(0)
+{
+}
+
+void WaveformBuilder::add(const float *samples, qsizetype frames)
+{
+    while (frames > 0) {
+        const qsizetype count = std::min(frames, SPAN_FRAMES - m_fill);
+        const float *end = samples + count * m_channels;
+        for (const float *sample = samples; sample < end; ++sample) {
+            m_min = std::min(m_min, *sample);
+            m_max = std::max(m_max, *sample);
+        }
+        m_fill += count;
+        if (m_fill == SPAN_FRAMES) {
+            m_spans.append(m_min);
+            m_spans.append(m_max);
+            m_min = 0;
+            m_max = 0;
+            m_fill = 0;
+        }
+        samples = end;
+        frames -= count;
+    }
+}
+
+Waveform WaveformBuilder::finish()
+{
+    if (m_fill > 0) {
+        m_spans.append(m_min);
+        m_spans.append(m_max);
+        m_fill = 0;
+    }
+
+    Waveform waveform;
+    const qsizetype spans = m_spans.size() / 2;
+    if (spans == 0) {
+        return waveform;
+    }
+
+    // Each bucket takes the extremes of the spans it covers; a short
+    // track repeats spans over several buckets
+    QVector<qint8> &finest = waveform.m_levels[0];
+    finest.resize(2 * Waveform::FINEST_BUCKETS);
+    for (int bucket = 0; bucket < Waveform::FINEST_BUCKETS; ++bucket) {
+        const qsizetype first = bucket * spans / Waveform::FINEST_BUCKETS;
+        const qsizetype last = std::max(first + 1, (bucket + 1) * spans / Waveform::FINEST_BUCKETS);
+        float low = m_spans.at(2 * first);
+        float high = m_spans.at(2 * first + 1);
+        for (qsizetype span = first + 1; span < last; ++span) {
+            low = std::min(low, m_spans.at(2 * span));
+            high = std::max(high, m_spans.at(2 * span + 1));
+        }
+        finest[2 * bucket] = toByte(low);
+        finest[2 * bucket + 1] = toByte(high);
+    }
+
+    for (int level = 1; level < Waveform::LEVELS; ++level) {
+        const QVector<qint8> &finer = waveform.m_levels[level - 1];
+        QVector<qint8> &coarser = waveform.m_levels[level];
+        coarser.resize(finer.size() / Waveform::REDUCTION);
+        for (qsizetype bucket = 0; bucket < coarser.size() / 2; ++bucket) {
+            qint8 low = finer.at(2 * bucket * Waveform::REDUCTION);
+            qint8 high = finer.at(2 * bucket * Waveform::REDUCTION + 1);
+            for (int i = 1; i < Waveform::REDUCTION; ++i) {
+                low = std::min(low, finer.at(2 * (bucket * Waveform::REDUCTION + i)));
+                high = std::max(high, finer.at(2 * (bucket * Waveform::REDUCTION + i) + 1));
+            }
+            coarser[2 * bucket] = low;
+            coarser[2 * bucket + 1] = high;
+        }
+    }
+
+    m_spans.clear();
+    return waveform;
+}
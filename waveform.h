@@ -0,0 +1,57 @@
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <QDataStream>
+#include <QVector>
+
+// Peaks of a track for drawing: the min and max sample of each bucket,
+// as signed bytes, at a few zoom levels. The finest level has 4096
+// buckets over the whole track and each coarser one a quarter of that,
+// so a view of any width finds a level with one to four buckets per
+// pixel. About 11 kB per track.
+class Waveform
+{
+public:
+    static constexpr int LEVELS = 3;
+    static constexpr int FINEST_BUCKETS = 4096;
+    static constexpr int REDUCTION = 4;
+
+    bool isNull() const { return m_levels[0].isEmpty(); }
+
+    // The coarsest level with at least buckets buckets, else the finest
+    int levelFor(int buckets) const;
+    int bucketCount(int level) const { return int(m_levels[level].size() / 2); }
+    qint8 minimum(int level, int bucket) const { return m_levels[level].at(2 * bucket); }
+    qint8 maximum(int level, int bucket) const { return m_levels[level].at(2 * bucket + 1); }
+
+private:
+    friend class WaveformBuilder;
+    friend QDataStream &operator<<(QDataStream &out, const Waveform &waveform);
+    friend QDataStream &operator>>(QDataStream &in, Waveform &waveform);
+
+    QVector<qint8> m_levels[LEVELS];    // min, max per bucket
+};
+
+QDataStream &operator<<(QDataStream &out, const Waveform &waveform);
+QDataStream &operator>>(QDataStream &in, Waveform &waveform);
+
+// Collects peaks from decoded audio of unknown length in small fixed
+// spans, then spreads them over the buckets once the track is done
+class WaveformBuilder
+{
+public:
+    explicit WaveformBuilder(int channels);
+
+    // Interleaved float samples
+    void add(const float *samples, qsizetype frames);
+    Waveform finish();
+
+private:
+    const int m_channels;
+    QVector<float> m_spans;     // min, max per span
+    float m_min;
+    float m_max;
+    qsizetype m_fill;           // frames in the open span
+};
+
+#endif // WAVEFORM_H
@@ -0,0 +1,75 @@
+#include "waveformgenerator.h"
+#include "waveformstore.h"
+#include "filedecoder.h"
+#include "logging.h"
+#include <QThread>
+#include <memory>
+
+WaveformGenerator::WaveformGenerator(QObject *parent)
+    : QObject(parent)
+    , m_generation(0)
+{
+    // One at a time, below the playback threads
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+WaveformGenerator::~WaveformGenerator()
+{
+    ++m_generation;
+    m_pool.waitForDone();
+}
+
+void WaveformGenerator::request(const QString &filePath, qint64 size, qint64 modified)
+{
+    const quint64 generation = ++m_generation;
+    m_pool.start([this, generation, filePath, size, modified]() {
+        work(generation, filePath, size, modified);
+    });
+}
+
+void WaveformGenerator::work(quint64 generation, const QString &filePath, qint64 size, qint64 modified)
+{
+    if (generation != m_generation) {
+        return;
+    }
+
+    const QString key = WaveformStore::key(filePath, size, modified);
+    Waveform waveform = WaveformStore::load(key);
+    if (waveform.isNull()) {
+        QAudioFormat format;
+        format.setSampleFormat(QAudioFormat::Float);
+        format.setSampleRate(48000);
+        format.setChannelCount(2);
+
+        std::unique_ptr<WaveformBuilder> builder;
+        QString errorString;
+        const bool ok = FileDecoder::decode(filePath, format, [&](const QAudioBuffer &buffer) {
+            const QAudioFormat bufferFormat = buffer.format();
+            if (bufferFormat.sampleFormat() != QAudioFormat::Float
+                    || (builder && bufferFormat.channelCount() != format.channelCount())) {
+                return false;
+            }
+            if (!builder) {
+                format = bufferFormat;
+                builder = std::make_unique<WaveformBuilder>(format.channelCount());
+            }
+            builder->add(buffer.constData<float>(), buffer.frameCount());
+            return generation == m_generation;
+        }, &errorString);
+
+        if (generation != m_generation) {
+            return;
+        }
+        if (ok && builder) {
+            waveform = builder->finish();
+            WaveformStore::store(key, waveform);
+        } else {
+            qCWarning(lcPlayback) << "Could not build waveform for" << filePath << errorString;
+        }
+    }
+
+    if (generation == m_generation) {
+        emit ready(filePath, waveform);
+    }
+}
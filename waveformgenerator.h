@@ -0,0 +1,34 @@
+#ifndef WAVEFORMGENERATOR_H
+#define WAVEFORMGENERATOR_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <atomic>
+#include "waveform.h"
+
+// Gets the waveform of the track being played: from the store if the
+// loudness analysis already made one, else by decoding the file on a
+// background thread and storing the result. Only the latest request
+// matters; an older one still decoding is abandoned.
+class WaveformGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WaveformGenerator(QObject *parent = nullptr);
+    ~WaveformGenerator();
+
+    void request(const QString &filePath, qint64 size, qint64 modified);
+
+signals:
+    // Null if the file could not be decoded
+    void ready(const QString &filePath, const Waveform &waveform);
+
+private:
+    void work(quint64 generation, const QString &filePath, qint64 size, qint64 modified);
+
+    QThreadPool m_pool;
+    std::atomic<quint64> m_generation;
+};
+
+#endif // WAVEFORMGENERATOR_H
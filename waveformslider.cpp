@@ -0,0 +1,134 @@
+#include "waveformslider.h"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QStyle>
+
+WaveformSlider::WaveformSlider(QWidget *parent)
+    : QSlider(Qt::Horizontal, parent)
+    , m_dirty(true)
+{
+}
+
+void WaveformSlider::setWaveform(const Waveform &waveform)
+{
+    m_waveform = waveform;
+    m_dirty = true;
+    update();
+}
+
+void WaveformSlider::clearWaveform()
+{
+    setWaveform(Waveform());
+}
+
+void WaveformSlider::paintEvent(QPaintEvent *event)
+{
+    if (m_waveform.isNull()) {
+        QSlider::paintEvent(event);
+        return;
+    }
+    if (m_dirty) {
+        render();
+    }
+
+    const qint64 range = qint64(maximum()) - minimum();
+    const int split = range > 0 ? int(qint64(width()) * (sliderPosition() - minimum()) / range) : 0;
+    const qreal ratio = m_played.devicePixelRatio();
+
+    QPainter painter(this);
+    painter.drawPixmap(QRectF(0, 0, split, height()), m_played,
+                       QRectF(0, 0, split * ratio, height() * ratio));
+    painter.drawPixmap(QRectF(split, 0, width() - split, height()), m_remaining,
+                       QRectF(split * ratio, 0, (width() - split) * ratio, height() * ratio));
+}
+
+void WaveformSlider::resizeEvent(QResizeEvent *event)
+{
+    m_dirty = true;
+    QSlider::resizeEvent(event);
+}
+
+void WaveformSlider::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::StyleChange) {
+        m_dirty = true;
+    }
+    QSlider::changeEvent(event);
+}
+
+void WaveformSlider::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QSlider::mousePressEvent(event);
+        return;
+    }
+    // Emits sliderPressed, then sliderMoved for the new position; only the
+    // handle moves until the release
+    setSliderDown(true);
+    setSliderPosition(valueAt(event->position().x()));
+    event->accept();
+}
+
+void WaveformSlider::mouseMoveEvent(QMouseEvent *event)
+{
+    if (isSliderDown()) {
+        setSliderPosition(valueAt(event->position().x()));
+        event->accept();
+    }
+}
+
+void WaveformSlider::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && isSliderDown()) {
+        setSliderDown(false);
+        event->accept();
+    }
+}
+
+int WaveformSlider::valueAt(qreal x) const
+{
+    return QStyle::sliderValueFromPosition(minimum(), maximum(), qRound(x), width());
+}
+
+void WaveformSlider::render()
+{
+    m_dirty = false;
+    const int w = width();
+    const int h = height();
+    const qreal ratio = devicePixelRatioF();
+    m_played = QPixmap(QSize(w, h) * ratio);
+    m_remaining = QPixmap(QSize(w, h) * ratio);
+    m_played.setDevicePixelRatio(ratio);
+    m_remaining.setDevicePixelRatio(ratio);
+    m_played.fill(Qt::transparent);
+    m_remaining.fill(Qt::transparent);
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    QPainter played(&m_played);
+    QPainter remaining(&m_remaining);
+    played.setPen(palette().color(QPalette::Highlight));
+    remaining.setPen(palette().color(QPalette::Mid));
+
+    // One to four buckets per column at the chosen level
+    const int level = m_waveform.levelFor(w);
+    const int buckets = m_waveform.bucketCount(level);
+    const qreal middle = h / 2.0;
+    const qreal scale = (h / 2.0 - 1.0) / 127.0;
+    for (int x = 0; x < w; ++x) {
+        const int first = int(qint64(x) * buckets / w);
+        const int last = qMax(first + 1, int(qint64(x + 1) * buckets / w));
+        int low = m_waveform.minimum(level, first);
+        int high = m_waveform.maximum(level, first);
+        for (int bucket = first + 1; bucket < last; ++bucket) {
+            low = qMin(low, int(m_waveform.minimum(level, bucket)));
+            high = qMax(high, int(m_waveform.maximum(level, bucket)));
+        }
+
+        // At least a pixel, so silence still shows the bar
+        const QLineF line(x + 0.5, middle - qMax(high, 1) * scale, x + 0.5, middle - qMin(low, -1) * scale);
+        played.drawLine(line);
+        remaining.drawLine(line);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef WAVEFORMSLIDER_H
+#define WAVEFORMSLIDER_H
+
+#include <QPixmap>
+#include <QSlider>
+#include "waveform.h"
+
+// Seek slider that draws the track's waveform, the played part in the
+// highlight color. The waveform is reduced to one column per pixel and
+// drawn into two pixmaps only when it, the size or the palette changes;
+// a position update just copies each pixmap's side of the playhead, so
+// painting never goes back to the peaks. Without a waveform it paints as
+// a plain QSlider. Pressing anywhere moves the handle there and dragging
+// follows; the owner seeks on sliderReleased().
+class WaveformSlider : public QSlider
+{
+    Q_OBJECT
+
+public:
+    explicit WaveformSlider(QWidget *parent = nullptr);
+
+    void setWaveform(const Waveform &waveform);
+    void clearWaveform();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    int valueAt(qreal x) const;
+    void render();
+
+    Waveform m_waveform;
+    QPixmap m_played;
+    QPixmap m_remaining;
+    bool m_dirty;   // the pixmaps need drawing again
+};
+
+#endif // WAVEFORMSLIDER_H
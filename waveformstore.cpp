@@ -0,0 +1,43 @@
+#include "waveformstore.h"
+#include "cachefile.h"
+#include <QCryptographicHash>
+
+namespace WaveformStore {
+
+namespace {
+    constexpr quint32 WAVEFORM_MAGIC = 0x4d574156; // "MWAV"
+    constexpr quint32 WAVEFORM_VERSION = 1;
+
+    const CacheFile<Waveform> &cache()
+    {
+        static const CacheFile<Waveform> file(QStringLiteral("waveforms"), QStringLiteral(".peaks"),
+                                              WAVEFORM_MAGIC, WAVEFORM_VERSION);
+        return file;
+    }
+}
+
+QString key(const QString &filePath, qint64 size, qint64 modified)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(filePath.toUtf8());
+    hash.addData(QByteArray::number(size));
+    hash.addData(QByteArray::number(modified));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool contains(const QString &key)
+{
+    return cache().contains(key);
+}
+
+bool store(const QString &key, const Waveform &waveform)
+{
+    return cache().store(key, waveform);
+}
+
+Waveform load(const QString &key)
+{
+    return cache().load(key);
+}
+
+}
@@ -0,0 +1,19 @@
+#ifndef WAVEFORMSTORE_H
+#define WAVEFORMSTORE_H
+
+#include <QString>
+#include "waveform.h"
+
+// On-disk cache of track waveforms, keyed by file path, size and
+// modification time so an edited file gets a new one. Safe to call from
+// any thread.
+namespace WaveformStore {
+    QString key(const QString &filePath, qint64 size, qint64 modified);
+
+    bool contains(const QString &key);
+    bool store(const QString &key, const Waveform &waveform);
+    // Null if not stored or unreadable
+    Waveform load(const QString &key);
+}
+
+#endif // WAVEFORMSTORE_H